@@ -1,6 +1,6 @@
 #include "PrecompiledHeader.hpp"
 #include "Application.hpp"
-#include <cctype>
+#include "PE\PortableExecutable.hpp"
 
 namespace
 {
@@ -10,6 +10,8 @@ namespace
 		std::vector<HAP::ShutdownFuncType> CloseFunctions;
 		std::vector<HAP::StartupFuncData> StartupFunctions;
 
+		HAP::PatternScanEngine ScanEngine = HAP::PatternScanEngine::Vector;
+
 		struct
 		{
 			HANDLE StdOutHandle = INVALID_HANDLE_VALUE;
@@ -36,46 +38,250 @@ namespace
 	namespace Memory
 	{
 		/*
-			Not accessing the STL iterators in debug mode makes this run >10x faster, less sitting around waiting for nothing.
+			FNV-1a
 		*/
-		inline bool DataCompare(const uint8_t* data, const HAP::BytePattern::Entry* pattern, size_t patternlength)
+		inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
 		{
-			int index = 0;
+			auto bytes = static_cast<const uint8_t*>(data);
 
-			for (size_t i = 0; i < patternlength; i++)
+			for (size_t i = 0; i < size; i++)
 			{
-				auto byte = *pattern;
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
 
-				if (!byte.Unknown && *data != byte.Value)
+		uint64_t HashPattern(const HAP::BytePattern& pattern)
+		{
+			uint64_t ret = HashBytes(nullptr, 0);
+
+			for (size_t i = 0; i < pattern.Length; i++)
+			{
+				uint8_t data[2] =
 				{
-					return false;
+					uint8_t(pattern.Values[i] & pattern.Masks[i]),
+					!pattern.IsKnown(i)
+				};
+
+				ret = HashBytes(data, sizeof(data), ret);
+			}
+
+			return ret;
+		}
+
+		/*
+			The header page holds the link timestamp, checksum and section layout
+			so any rebuild of the library gives a different identity.
+		*/
+		uint64_t GetModuleIdentity(const HAP::ModuleInformation& library)
+		{
+			auto headersize = std::min<size_t>(4096, library.MemorySize);
+
+			auto ret = HashBytes(library.MemoryBase, headersize);
+			ret = HashBytes(&library.MemorySize, sizeof(library.MemorySize), ret);
+
+			return ret;
+		}
+
+		bool IsPatternAt(const HAP::ModuleInformation& library, const HAP::BytePattern& pattern, size_t rva)
+		{
+			auto length = pattern.Length;
+
+			if (length == 0 || length > library.MemorySize || rva > library.MemorySize - length)
+			{
+				return false;
+			}
+
+			auto addr = static_cast<const uint8_t*>(library.MemoryBase) + rva;
+			return HAP::Scanner::ComparePattern(addr, pattern);
+		}
+	}
+
+	/*
+		Resolved pattern addresses from earlier runs, stored relative to the library base.
+		Entries are only used if the library identity and pattern are unchanged and the
+		pattern still matches at the stored address.
+	*/
+	namespace AddressCache
+	{
+		auto FileName = "HammerPatchAddresses.cache";
+
+		enum
+		{
+			Version = 1
+		};
+
+		struct Entry
+		{
+			std::string Library;
+			std::string Name;
+
+			uint64_t Identity;
+			uint64_t PatternHash;
+			uint32_t RVA;
+		};
+
+		std::vector<Entry> Entries;
+		bool Changed = false;
+
+		void Load()
+		{
+			Entries.clear();
+			Changed = false;
+
+			auto file = fopen(FileName, "r");
+
+			if (!file)
+			{
+				return;
+			}
+
+			int version = 0;
+
+			if (fscanf(file, "%d", &version) != 1 || version != Version)
+			{
+				fclose(file);
+				return;
+			}
+
+			while (true)
+			{
+				char library[256];
+				char name[256];
+				unsigned long long identity;
+				unsigned long long patternhash;
+				unsigned int rva;
+
+				auto res = fscanf(file, "%255s %255s %llx %llx %x", library, name, &identity, &patternhash, &rva);
+
+				if (res != 5)
+				{
+					break;
 				}
-				
-				++data;
-				++pattern;
-				++index;
+
+				Entry entry;
+				entry.Library = library;
+				entry.Name = name;
+				entry.Identity = identity;
+				entry.PatternHash = patternhash;
+				entry.RVA = rva;
+
+				Entries.emplace_back(std::move(entry));
+			}
+
+			fclose(file);
+		}
+
+		void Save()
+		{
+			if (!Changed)
+			{
+				return;
+			}
+
+			auto file = fopen(FileName, "w");
+
+			if (!file)
+			{
+				HAP::MessageWarning("Could not write address cache\n");
+				return;
 			}
 
-			return index == patternlength;
+			fprintf(file, "%d\n", Version);
+
+			for (const auto& entry : Entries)
+			{
+				fprintf(file, "%s %s %llx %llx %x\n", entry.Library.c_str(), entry.Name.c_str(), (unsigned long long)entry.Identity, (unsigned long long)entry.PatternHash, entry.RVA);
+			}
+
+			fclose(file);
+			Changed = false;
 		}
 
-		void* FindPattern(void* start, size_t searchlength, const HAP::BytePattern& pattern)
+		Entry* Find(const char* library, const char* name)
 		{
-			auto patternstart = pattern.Bytes.data();
-			auto length = pattern.Bytes.size();
-			
-			for (size_t i = 0; i <= searchlength - length; ++i)
+			for (auto& entry : Entries)
 			{
-				auto addr = (const uint8_t*)(start) + i;
-				
-				if (DataCompare(addr, patternstart, length))
+				if (_stricmp(entry.Library.c_str(), library) == 0 && entry.Name == name)
 				{
-					return (void*)(addr);
+					return &entry;
 				}
 			}
 
 			return nullptr;
 		}
+
+		bool Get(const HAP::ModuleInformation& library, uint64_t identity, const char* name, const HAP::BytePattern& pattern, void*& address)
+		{
+			auto entry = Find(library.Name, name);
+
+			if (!entry || entry->Identity != identity || entry->PatternHash != Memory::HashPattern(pattern))
+			{
+				return false;
+			}
+
+			if (!Memory::IsPatternAt(library, pattern, entry->RVA))
+			{
+				return false;
+			}
+
+			address = static_cast<uint8_t*>(library.MemoryBase) + entry->RVA;
+			return true;
+		}
+
+		void Set(const HAP::ModuleInformation& library, uint64_t identity, const char* name, const HAP::BytePattern& pattern, void* address)
+		{
+			auto entry = Find(library.Name, name);
+
+			if (!entry)
+			{
+				Entry newentry;
+				newentry.Library = library.Name;
+				newentry.Name = name;
+
+				Entries.emplace_back(std::move(newentry));
+				entry = &Entries.back();
+			}
+
+			entry->Identity = identity;
+			entry->PatternHash = Memory::HashPattern(pattern);
+			entry->RVA = static_cast<uint32_t>(static_cast<uint8_t*>(address) - static_cast<uint8_t*>(library.MemoryBase));
+
+			Changed = true;
+		}
+	}
+
+	std::vector<HAP::PE::ImageRange> GetSearchRanges(const HAP::ModuleInformation& library, const char* section)
+	{
+		HAP::PE::ImageHeaders headers;
+
+		if (!HAP::PE::ReadHeaders(library.MemoryBase, library.MemorySize, headers))
+		{
+			if (section)
+			{
+				return {};
+			}
+
+			HAP::PE::ImageRange range;
+			range.Offset = 0;
+			range.Length = library.MemorySize;
+
+			return { range };
+		}
+
+		return HAP::PE::GetCodeRanges(headers, HAP::PE::ImageLayout::Mapped, library.MemorySize, section);
+	}
+
+	bool IsSameSection(const char* first, const char* second)
+	{
+		if (!first || !second)
+		{
+			return first == second;
+		}
+
+		return std::strcmp(first, second) == 0;
 	}
 }
 
@@ -104,6 +310,121 @@ void HAP::CreateModules()
 		throw res;
 	}
 
+	/*
+		Find the targets of all pattern modules up front, one scan per library section.
+	*/
+	struct SearchGroup
+	{
+		const char* Library;
+		const char* Section;
+	};
+
+	std::vector<SearchGroup> groups;
+
+	for (auto module : MainApplication.Modules)
+	{
+		if (!module->GetPattern())
+		{
+			continue;
+		}
+
+		auto found = false;
+
+		for (const auto& group : groups)
+		{
+			if (_stricmp(group.Library, module->Module) == 0 && IsSameSection(group.Section, module->Section))
+			{
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+		{
+			SearchGroup group;
+			group.Library = module->Module;
+			group.Section = module->Section;
+
+			groups.emplace_back(group);
+		}
+	}
+
+	AddressCache::Load();
+
+	for (const auto& group : groups)
+	{
+		auto library = group.Library;
+
+		ModuleInformation info(library);
+		auto identity = Memory::GetModuleIdentity(info);
+
+		std::vector<HookModuleBase*> modules;
+		std::vector<const BytePattern*> patterns;
+
+		size_t cached = 0;
+
+		for (auto module : MainApplication.Modules)
+		{
+			auto pattern = module->GetPattern();
+
+			if (!pattern || _stricmp(library, module->Module) != 0 || !IsSameSection(group.Section, module->Section))
+			{
+				continue;
+			}
+
+			module->Searched = true;
+
+			if (AddressCache::Get(info, identity, module->DisplayName, *pattern, module->TargetFunction))
+			{
+				++cached;
+				continue;
+			}
+
+			modules.emplace_back(module);
+			patterns.emplace_back(pattern);
+		}
+
+		if (!patterns.empty())
+		{
+			auto addresses = GetAddressesFromPatterns(info, patterns, group.Section);
+
+			for (size_t i = 0; i < modules.size(); i++)
+			{
+				auto module = modules[i];
+				module->TargetFunction = addresses[i];
+
+				if (module->TargetFunction)
+				{
+					AddressCache::Set(info, identity, module->DisplayName, *patterns[i], module->TargetFunction);
+				}
+			}
+		}
+
+		MessageNormal("Resolved %d patterns in \"%s\" (%d cached)\n", cached + patterns.size(), library, cached);
+	}
+
+	AddressCache::Save();
+
+	for (auto module : MainApplication.Modules)
+	{
+		auto pattern = module->GetPattern();
+
+		if (!pattern || !module->TargetFunction)
+		{
+			continue;
+		}
+
+		for (size_t i = 0; i < pattern->CaptureCount; i++)
+		{
+			const auto& capture = pattern->Captures[i];
+			auto value = ReadCapture(module->TargetFunction, capture);
+
+			module->Captures.emplace_back(value);
+
+			MessageNormal("Captured \"%s\" = %d in \"%s\"\n", capture.Name, value, module->DisplayName);
+		}
+	}
+
 	MessageNormal("Creating %d modules\n", MainApplication.Modules.size());
 
 	for (auto module : MainApplication.Modules)
@@ -126,6 +447,33 @@ void HAP::CreateModules()
 	}
 }
 
+bool HAP::HookModuleBase::GetCapture(const char* name, int32_t& value) const
+{
+	auto pattern = GetPattern();
+
+	if (!pattern)
+	{
+		return false;
+	}
+
+	auto capture = pattern->FindCapture(name);
+
+	if (!capture)
+	{
+		return false;
+	}
+
+	size_t index = capture - pattern->Captures;
+
+	if (index >= Captures.size())
+	{
+		return false;
+	}
+
+	value = Captures[index];
+	return true;
+}
+
 void HAP::Close()
 {
 	for (auto&& func : MainApplication.CloseFunctions)
@@ -182,42 +530,60 @@ void HAP::CallStartupFunctions()
 	}
 }
 
-HAP::BytePattern HAP::GetPatternFromString(const char* input)
+void* HAP::GetAddressFromPattern(const ModuleInformation& library, const BytePattern& pattern, const char* section)
 {
-	BytePattern ret;
-
-	while (*input)
+	for (const auto& range : GetSearchRanges(library, section))
 	{
-		if (std::isspace(*input))
+		auto start = static_cast<uint8_t*>(library.MemoryBase) + range.Offset;
+		auto ret = Scanner::FindPatternParallel(start, range.Length, pattern, MainApplication.ScanEngine);
+
+		if (ret)
 		{
-			++input;
+			return ret;
 		}
+	}
+
+	return nullptr;
+}
 
-		BytePattern::Entry entry;
+std::vector<void*> HAP::GetAddressesFromPatterns(const ModuleInformation& library, const std::vector<const BytePattern*>& patterns, const char* section)
+{
+	std::vector<void*> ret(patterns.size(), nullptr);
 
-		if (std::isxdigit(*input))
-		{
-			entry.Unknown = false;
-			entry.Value = std::strtol(input, nullptr, 16);
+	for (const auto& range : GetSearchRanges(library, section))
+	{
+		std::vector<const BytePattern*> pending;
+		std::vector<size_t> indices;
 
-			input += 2;
+		for (size_t i = 0; i < patterns.size(); i++)
+		{
+			if (!ret[i])
+			{
+				pending.emplace_back(patterns[i]);
+				indices.emplace_back(i);
+			}
 		}
 
-		else
+		if (pending.empty())
 		{
-			entry.Unknown = true;
-			input += 2;
+			break;
 		}
 
-		ret.Bytes.emplace_back(entry);
+		auto start = static_cast<uint8_t*>(library.MemoryBase) + range.Offset;
+		auto results = Scanner::FindPatternsParallel(start, range.Length, pending, MainApplication.ScanEngine);
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			ret[indices[i]] = results[i];
+		}
 	}
 
 	return ret;
 }
 
-void* HAP::GetAddressFromPattern(const ModuleInformation& library, const BytePattern& pattern)
+void HAP::SetPatternScanEngine(PatternScanEngine engine)
 {
-	return Memory::FindPattern(library.MemoryBase, library.MemorySize, pattern);
+	MainApplication.ScanEngine = engine;
 }
 
 void HAP::AddModule(HookModuleBase* module)
@@ -225,6 +591,25 @@ void HAP::AddModule(HookModuleBase* module)
 	MainApplication.Modules.emplace_back(module);
 }
 
+bool HAP::HasCommandLineSwitch(const char* name)
+{
+	auto line = GetCommandLineA();
+	auto length = strlen(name);
+
+	for (auto pos = strstr(line, name); pos; pos = strstr(pos + 1, name))
+	{
+		auto isstart = pos == line || isspace(static_cast<unsigned char>(pos[-1]));
+		auto isend = pos[length] == 0 || isspace(static_cast<unsigned char>(pos[length]));
+
+		if (isstart && isend)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool HAP::IsGame(const wchar_t* test)
 {
 	/*
@@ -233,7 +618,7 @@ bool HAP::IsGame(const wchar_t* test)
 	*/
 
 	wchar_t directory[4096];
-	GetCurrentDirectoryW(sizeof(directory), directory);
+	GetCurrentDirectoryW(ARRAYSIZE(directory), directory);
 	PathRemoveFileSpecW(directory);
 	
 	auto name = PathFindFileNameW(directory);
@@ -243,5 +628,41 @@ bool HAP::IsGame(const wchar_t* test)
 
 bool HAP::IsCSGO()
 {
-	return IsGame(L"Counter-Strike Global Offensive");
+	return GetGameProfile() == GameProfile::CSGO;
+}
+
+namespace
+{
+	struct GameDirectory
+	{
+		const wchar_t* Name;
+		HAP::GameProfile Profile;
+	};
+
+	/*
+		Anything not listed here is assumed to be on the Source 2013 branch.
+	*/
+	const GameDirectory GameDirectories[] =
+	{
+		{ L"Counter-Strike Global Offensive", HAP::GameProfile::CSGO },
+	};
+
+	HAP::GameProfile ResolveGameProfile()
+	{
+		for (const auto& entry : GameDirectories)
+		{
+			if (HAP::IsGame(entry.Name))
+			{
+				return entry.Profile;
+			}
+		}
+
+		return HAP::GameProfile::Source2013;
+	}
+}
+
+HAP::GameProfile HAP::GetGameProfile()
+{
+	static auto profile = ResolveGameProfile();
+	return profile;
 }
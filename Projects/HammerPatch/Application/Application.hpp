@@ -1,4 +1,5 @@
 #pragma once
+#include "Scanner\PatternScanner.hpp"
 
 namespace HAP
 {
@@ -91,19 +92,19 @@ namespace HAP
 		size_t MemorySize;
 	};
 
-	struct BytePattern
-	{
-		struct Entry
-		{
-			uint8_t Value;
-			bool Unknown;
-		};
+	void SetPatternScanEngine(PatternScanEngine engine);
 
-		std::vector<Entry> Bytes;
-	};
+	/*
+		Only the executable sections of the library are searched, or
+		only the section called "section" if one is given.
+	*/
+	void* GetAddressFromPattern(const ModuleInformation& library, const BytePattern& pattern, const char* section = nullptr);
 
-	BytePattern GetPatternFromString(const char* input);
-	void* GetAddressFromPattern(const ModuleInformation& library, const BytePattern& pattern);
+	/*
+		Resolves all patterns with one pass over the module, the returned
+		addresses are in the same order as the input.
+	*/
+	std::vector<void*> GetAddressesFromPatterns(const ModuleInformation& library, const std::vector<const BytePattern*>& patterns, const char* section = nullptr);
 
 	struct HookModuleBase
 	{
@@ -118,10 +119,38 @@ namespace HAP
 		const char* DisplayName;
 		const char* Module;
 
-		void* TargetFunction;
+		/*
+			Optional name of the library section the target is in, such as ".text".
+		*/
+		const char* Section = nullptr;
+
+		void* TargetFunction = nullptr;
 		void* NewFunction;
 		void* OriginalFunction;
 
+		/*
+			Set once the pattern was looked up together with the rest of its library,
+			a target that is still null after that was not found.
+		*/
+		bool Searched = false;
+
+		/*
+			Modules that return a pattern here get their target function
+			resolved in a batch together with all other modules of the same library.
+		*/
+		virtual const BytePattern* GetPattern() const
+		{
+			return nullptr;
+		}
+
+		/*
+			Values of the pattern's capture slots in the same order, read from
+			the target function right after it is found and before it is hooked.
+		*/
+		std::vector<int32_t> Captures;
+
+		bool GetCapture(const char* name, int32_t& value) const;
+
 		virtual MH_STATUS Create() = 0;
 	};
 
@@ -131,10 +160,11 @@ namespace HAP
 	class HookModuleMask final : public HookModuleBase
 	{
 	public:
-		HookModuleMask(const char* module, const char* name, FuncSignature newfunction, const char* pattern) :
+		HookModuleMask(const char* module, const char* name, FuncSignature newfunction, const BytePattern& pattern, const char* section = nullptr) :
 			HookModuleBase(module, name, newfunction),
-			Pattern(GetPatternFromString(pattern))
+			Pattern(pattern)
 		{
+			Section = section;
 			AddModule(this);
 		}
 
@@ -143,10 +173,24 @@ namespace HAP
 			return static_cast<FuncSignature>(OriginalFunction);
 		}
 
+		virtual const BytePattern* GetPattern() const override
+		{
+			return &Pattern;
+		}
+
 		virtual MH_STATUS Create() override
 		{
-			ModuleInformation info(Module);
-			TargetFunction = GetAddressFromPattern(info, Pattern);
+			if (!TargetFunction && !Searched)
+			{
+				ModuleInformation info(Module);
+				TargetFunction = GetAddressFromPattern(info, Pattern, Section);
+			}
+
+			if (!TargetFunction)
+			{
+				MessageWarning("No match for the \"%s\" pattern in \"%s\"\n", DisplayName, Module);
+				return MH_ERROR_FUNCTION_NOT_FOUND;
+			}
 
 			auto res = MH_CreateHookEx(TargetFunction, NewFunction, &OriginalFunction);
 			return res;
@@ -156,6 +200,42 @@ namespace HAP
 		BytePattern Pattern;
 	};
 
+	/*
+		Hooks a function that a library exports by name, such as ExitProcess in kernel32.dll.
+	*/
+	template <typename FuncSignature>
+	class HookModuleAPI final : public HookModuleBase
+	{
+	public:
+		HookModuleAPI(const char* module, const char* name, const char* function, FuncSignature newfunction) :
+			HookModuleBase(module, name, newfunction),
+			Function(function)
+		{
+			AddModule(this);
+		}
+
+		inline auto GetOriginal() const
+		{
+			return static_cast<FuncSignature>(OriginalFunction);
+		}
+
+		virtual MH_STATUS Create() override
+		{
+			TargetFunction = GetProcAddress(GetModuleHandleA(Module), Function);
+
+			if (!TargetFunction)
+			{
+				return MH_ERROR_FUNCTION_NOT_FOUND;
+			}
+
+			auto res = MH_CreateHookEx(TargetFunction, NewFunction, &OriginalFunction);
+			return res;
+		}
+
+	private:
+		const char* Function;
+	};
+
 	struct StructureWalker
 	{
 		StructureWalker(void* address) :
@@ -189,6 +269,39 @@ namespace HAP
 		uint8_t* Start;
 	};
 
+	/*
+		Exact match of a switch such as "-hpcompress" on Hammer's command line.
+	*/
+	bool HasCommandLineSwitch(const char* name);
+
 	bool IsGame(const wchar_t* test);
 	bool IsCSGO();
+
+	/*
+		Source branches with their own Hammer build. A new branch needs an entry
+		here, its directory in the game table and its structure offsets.
+	*/
+	enum class GameProfile
+	{
+		Source2013,
+		CSGO,
+
+		Count
+	};
+
+	/*
+		Resolved from the game directory on first use, free afterwards.
+	*/
+	GameProfile GetGameProfile();
+
+	/*
+		Picks the entry of the running game from a list ordered like GameProfile.
+	*/
+	template <typename T, size_t Size>
+	const T& SelectForGame(const T(&values)[Size])
+	{
+		static_assert(Size == static_cast<size_t>(GameProfile::Count), "Missing game profile entries");
+
+		return values[static_cast<size_t>(GetGameProfile())];
+	}
 }
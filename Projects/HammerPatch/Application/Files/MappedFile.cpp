@@ -0,0 +1,132 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HAP
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+		auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER filesize;
+
+		if (!GetFileSizeEx(file, &filesize) || filesize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		/*
+			The mapping keeps the file open by itself.
+		*/
+		CloseHandle(file);
+
+		if (!mapping)
+		{
+			return false;
+		}
+
+		auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (!view)
+		{
+			CloseHandle(mapping);
+			return false;
+		}
+
+		Mapping = mapping;
+		Data = static_cast<const uint8_t*>(view);
+		Size = static_cast<size_t>(filesize.QuadPart);
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (Data)
+		{
+			UnmapViewOfFile(Data);
+			CloseHandle(Mapping);
+		}
+
+		Mapping = nullptr;
+		Data = nullptr;
+		Size = 0;
+	}
+#else
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+		auto file = open(path.c_str(), O_RDONLY);
+
+		if (file == -1)
+		{
+			return false;
+		}
+
+		struct stat info;
+
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		auto view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		close(file);
+
+		if (view == MAP_FAILED)
+		{
+			return false;
+		}
+
+		/*
+			Every byte is going to be read, start reading ahead now.
+		*/
+		madvise(view, info.st_size, MADV_WILLNEED);
+
+		Data = static_cast<const uint8_t*>(view);
+		Size = static_cast<size_t>(info.st_size);
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (Data)
+		{
+			munmap(const_cast<uint8_t*>(Data), Size);
+		}
+
+		Data = nullptr;
+		Size = 0;
+	}
+#endif
+}
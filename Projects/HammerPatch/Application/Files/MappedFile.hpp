@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace HAP
+{
+	/*
+		Read only view of a whole file. Nothing is copied, pages are
+		brought in by the system as the scanners touch them.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		const uint8_t* GetData() const
+		{
+			return Data;
+		}
+
+		size_t GetSize() const
+		{
+			return Size;
+		}
+
+	private:
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+
+#ifdef _WIN32
+		void* Mapping = nullptr;
+#endif
+	};
+}
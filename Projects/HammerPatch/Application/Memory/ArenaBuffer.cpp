@@ -0,0 +1,104 @@
+#include "ArenaBuffer.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+void HAP::ArenaBuffer::Append(const void* data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+
+	/*
+		Large appends fill up the current block before starting new ones.
+	*/
+	while (size > 0)
+	{
+		size_t amount;
+
+		if (!Blocks.empty() && Blocks.back().Used < Blocks.back().Capacity)
+		{
+			auto& block = Blocks.back();
+			amount = std::min(size, block.Capacity - block.Used);
+		}
+
+		else
+		{
+			amount = std::min(size, BlockSize);
+		}
+
+		auto dest = Reserve(amount);
+		std::memcpy(dest, bytes, amount);
+		Commit(amount);
+
+		bytes += amount;
+		size -= amount;
+	}
+}
+
+void HAP::ArenaBuffer::AppendView(const void* data, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	Block block;
+	block.View = static_cast<const uint8_t*>(data);
+	block.Capacity = size;
+	block.Used = size;
+
+	Blocks.emplace_back(std::move(block));
+
+	TotalSize += size;
+}
+
+uint8_t* HAP::ArenaBuffer::Reserve(size_t size)
+{
+	if (Blocks.empty() || Blocks.back().View || Blocks.back().Capacity - Blocks.back().Used < size)
+	{
+		Block block;
+		block.Capacity = std::max(size, BlockSize);
+		block.Data.reset(new uint8_t[block.Capacity]);
+		block.Used = 0;
+
+		Blocks.emplace_back(std::move(block));
+	}
+
+	auto& block = Blocks.back();
+	return block.Data.get() + block.Used;
+}
+
+void HAP::ArenaBuffer::Commit(size_t size)
+{
+	Blocks.back().Used += size;
+	TotalSize += size;
+}
+
+void HAP::ArenaBuffer::Clear()
+{
+	std::vector<Block>().swap(Blocks);
+	TotalSize = 0;
+}
+
+void HAP::ArenaBuffer::Splice(ArenaBuffer& other)
+{
+	for (auto& block : other.Blocks)
+	{
+		Blocks.emplace_back(std::move(block));
+	}
+
+	TotalSize += other.TotalSize;
+
+	other.Clear();
+}
+
+void HAP::ArenaBuffer::CopyTo(std::vector<uint8_t>& output) const
+{
+	output.clear();
+	output.reserve(TotalSize);
+
+	ForEachBlock([&](const uint8_t* data, size_t size)
+	{
+		output.insert(output.end(), data, data + size);
+		return true;
+	});
+}
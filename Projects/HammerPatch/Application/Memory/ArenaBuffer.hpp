@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace HAP
+{
+	/*
+		Growable byte buffer made of large blocks. Appending never moves what is
+		already written and never needs one contiguous allocation for everything,
+		which matters in Hammer's 32 bit address space.
+	*/
+	class ArenaBuffer
+	{
+	public:
+		explicit ArenaBuffer(size_t blocksize = 1 << 20) : BlockSize(blocksize)
+		{
+
+		}
+
+		void Append(const void* data, size_t size);
+
+		/*
+			Adds memory owned by someone else without copying it. It has to stay
+			alive and unchanged for as long as this buffer refers to it.
+		*/
+		void AppendView(const void* data, size_t size);
+
+		/*
+			Contiguous space for at least "size" bytes, of which "Commit"
+			then marks how many were used.
+		*/
+		uint8_t* Reserve(size_t size);
+		void Commit(size_t size);
+
+		size_t GetSize() const
+		{
+			return TotalSize;
+		}
+
+		/*
+			Releases all blocks.
+		*/
+		void Clear();
+
+		/*
+			Calls "func" with the data and size of every block in order
+			until it returns false.
+		*/
+		template <typename Func>
+		bool ForEachBlock(Func&& func) const
+		{
+			for (const auto& block : Blocks)
+			{
+				if (block.Used > 0 && !func(block.View ? block.View : block.Data.get(), block.Used))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/*
+			Moves all blocks of "other" to the end without copying them, "other" is left empty.
+		*/
+		void Splice(ArenaBuffer& other);
+
+		void CopyTo(std::vector<uint8_t>& output) const;
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> Data;
+
+			/*
+				Set instead of "Data" for blocks from AppendView, which are full.
+			*/
+			const uint8_t* View = nullptr;
+
+			size_t Capacity;
+			size_t Used;
+		};
+
+		std::vector<Block> Blocks;
+
+		size_t BlockSize;
+		size_t TotalSize = 0;
+	};
+}
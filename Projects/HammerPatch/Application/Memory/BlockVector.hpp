@@ -0,0 +1,128 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace HAP
+{
+	/*
+		Array of trivial records that grows one block at a time. Adding to it never moves
+		or copies what is already there, so records keep their address and there is
+		no unused reserve beyond the last block.
+	*/
+	template <typename T, size_t BlockCount = 16384>
+	class BlockVector
+	{
+		static_assert((BlockCount & (BlockCount - 1)) == 0, "Blocks have to be a power of two records");
+
+	public:
+		size_t GetSize() const
+		{
+			return Count;
+		}
+
+		bool IsEmpty() const
+		{
+			return Count == 0;
+		}
+
+		T& operator[](size_t index)
+		{
+			return Blocks[index / BlockCount][index % BlockCount];
+		}
+
+		const T& operator[](size_t index) const
+		{
+			return Blocks[index / BlockCount][index % BlockCount];
+		}
+
+		T& Back()
+		{
+			return (*this)[Count - 1];
+		}
+
+		void Add(const T& value)
+		{
+			if (Count == Blocks.size() * BlockCount)
+			{
+				Blocks.emplace_back(new T[BlockCount]);
+			}
+
+			(*this)[Count++] = value;
+		}
+
+		void Append(const T* data, size_t count)
+		{
+			while (count > 0)
+			{
+				if (Count == Blocks.size() * BlockCount)
+				{
+					Blocks.emplace_back(new T[BlockCount]);
+				}
+
+				auto offset = Count % BlockCount;
+				auto amount = std::min(count, BlockCount - offset);
+
+				std::copy(data, data + amount, Blocks.back().get() + offset);
+
+				Count += amount;
+				data += amount;
+				count -= amount;
+			}
+		}
+
+		/*
+			Releases all blocks.
+		*/
+		void Clear()
+		{
+			std::vector<std::unique_ptr<T[]>>().swap(Blocks);
+			Count = 0;
+		}
+
+		/*
+			Calls "func" with the address and count of every contiguous
+			run of records in the range, in order.
+		*/
+		template <typename Func>
+		void ForEachRun(size_t first, size_t count, Func&& func) const
+		{
+			while (count > 0)
+			{
+				auto offset = first % BlockCount;
+				auto amount = std::min(count, BlockCount - offset);
+
+				func(Blocks[first / BlockCount].get() + offset, amount);
+
+				first += amount;
+				count -= amount;
+			}
+		}
+
+		/*
+			Address of "count" records from "first" in one piece. Ranges that cross
+			a block are copied to "scratch" first.
+		*/
+		const T* GetRange(size_t first, size_t count, std::vector<T>& scratch) const
+		{
+			if (count == 0 || first % BlockCount + count <= BlockCount)
+			{
+				return count ? &(*this)[first] : nullptr;
+			}
+
+			scratch.clear();
+
+			ForEachRun(first, count, [&](const T* data, size_t amount)
+			{
+				scratch.insert(scratch.end(), data, data + amount);
+			});
+
+			return scratch.data();
+		}
+
+	private:
+		std::vector<std::unique_ptr<T[]>> Blocks;
+		size_t Count = 0;
+	};
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace HAP
+{
+	/*
+		64 bit hash for telling data apart quickly, it is not meant to hold up against
+		deliberate collisions. Passing the previous result as "seed" hashes several
+		pieces of data as if they were one.
+	*/
+	inline uint64_t FastHash(const void* data, size_t size, uint64_t seed = 0)
+	{
+		const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+		const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+		const uint64_t prime3 = 0x165667B19E3779F9ull;
+
+		auto rotate = [](uint64_t value, int count)
+		{
+			return (value << count) | (value >> (64 - count));
+		};
+
+		auto bytes = static_cast<const uint8_t*>(data);
+		auto hash = seed ^ (size * prime1);
+
+		auto mix = [&](uint64_t value)
+		{
+			hash ^= rotate(value * prime2, 31) * prime1;
+			hash = rotate(hash, 27) * prime1 + prime3;
+		};
+
+		while (size >= sizeof(uint64_t))
+		{
+			uint64_t value;
+			std::memcpy(&value, bytes, sizeof(value));
+
+			mix(value);
+
+			bytes += sizeof(value);
+			size -= sizeof(value);
+		}
+
+		/*
+			The length is already part of the hash, so zero padding cannot collide.
+		*/
+		if (size > 0)
+		{
+			uint64_t value = 0;
+			std::memcpy(&value, bytes, size);
+
+			mix(value);
+		}
+
+		hash ^= hash >> 33;
+		hash *= prime2;
+		hash ^= hash >> 29;
+		hash *= prime3;
+		hash ^= hash >> 32;
+
+		return hash;
+	}
+}
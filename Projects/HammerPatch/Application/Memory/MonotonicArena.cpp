@@ -0,0 +1,70 @@
+#include "MonotonicArena.hpp"
+
+#include <algorithm>
+
+void* HAP::MonotonicArena::Allocate(size_t size, size_t alignment)
+{
+	Stats.Allocations++;
+
+	if (!Blocks.empty())
+	{
+		auto& block = Blocks.back();
+
+		auto address = reinterpret_cast<uintptr_t>(block.Data.get()) + block.Used;
+		auto padding = (alignment - address % alignment) % alignment;
+
+		if (padding <= block.Capacity - block.Used && size <= block.Capacity - block.Used - padding)
+		{
+			block.Used += padding + size;
+			UsedBytes += padding + size;
+
+			Stats.HighWaterMark = std::max(Stats.HighWaterMark, UsedBytes);
+
+			return reinterpret_cast<void*>(address + padding);
+		}
+	}
+
+	/*
+		New blocks are aligned for any type. Anything larger than a block gets one of its
+		own, which goes in front of the last block so that one can still be filled up.
+	*/
+	Block block;
+	block.Capacity = std::max(size, BlockSize);
+	block.Data.reset(new uint8_t[block.Capacity]);
+	block.Used = size;
+
+	auto data = block.Data.get();
+
+	if (block.Capacity > BlockSize && !Blocks.empty())
+	{
+		Blocks.insert(Blocks.end() - 1, std::move(block));
+	}
+
+	else
+	{
+		Blocks.emplace_back(std::move(block));
+	}
+
+	UsedBytes += size;
+	ReservedBytes += std::max(size, BlockSize);
+
+	Stats.HighWaterMark = std::max(Stats.HighWaterMark, UsedBytes);
+	Stats.PeakBytes = std::max(Stats.PeakBytes, ReservedBytes);
+
+	return data;
+}
+
+void HAP::MonotonicArena::Release()
+{
+	std::vector<Block>().swap(Blocks);
+
+	UsedBytes = 0;
+	ReservedBytes = 0;
+}
+
+void HAP::MonotonicArena::ResetCounters()
+{
+	Stats = {};
+	Stats.HighWaterMark = UsedBytes;
+	Stats.PeakBytes = ReservedBytes;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace HAP
+{
+	/*
+		Hands out memory from large blocks that are only given back all at once,
+		so structures that live and die together do not fragment the heap. That
+		matters in Hammer's 32 bit address space. Not thread safe.
+	*/
+	class MonotonicArena
+	{
+	public:
+		struct Counters
+		{
+			size_t Allocations = 0;
+
+			/*
+				Most bytes handed out at once, including alignment.
+			*/
+			size_t HighWaterMark = 0;
+
+			/*
+				Most bytes held in blocks at once.
+			*/
+			size_t PeakBytes = 0;
+		};
+
+		explicit MonotonicArena(size_t blocksize = 1 << 20) : BlockSize(blocksize)
+		{
+
+		}
+
+		MonotonicArena(const MonotonicArena&) = delete;
+		MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment);
+
+		/*
+			Frees every block. Counters keep counting until they are reset.
+		*/
+		void Release();
+
+		const Counters& GetCounters() const
+		{
+			return Stats;
+		}
+
+		void ResetCounters();
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> Data;
+
+			size_t Capacity;
+			size_t Used;
+		};
+
+		std::vector<Block> Blocks;
+
+		size_t BlockSize;
+
+		size_t UsedBytes = 0;
+		size_t ReservedBytes = 0;
+
+		Counters Stats;
+	};
+
+	/*
+		For standard containers. Memory is only freed when the whole arena is.
+	*/
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		explicit ArenaAllocator(MonotonicArena& arena) : Arena(&arena)
+		{
+
+		}
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : Arena(other.Arena)
+		{
+
+		}
+
+		T* allocate(size_t count)
+		{
+			if (count > SIZE_MAX / sizeof(T))
+			{
+				throw std::bad_alloc();
+			}
+
+			return static_cast<T*>(Arena->Allocate(count * sizeof(T), alignof(T)));
+		}
+
+		/*
+			Given back when the arena is released.
+		*/
+		void deallocate(T*, size_t)
+		{
+
+		}
+
+		template <typename U>
+		bool operator==(const ArenaAllocator<U>& other) const
+		{
+			return Arena == other.Arena;
+		}
+
+		template <typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const
+		{
+			return Arena != other.Arena;
+		}
+
+		MonotonicArena* Arena;
+	};
+
+	template <typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
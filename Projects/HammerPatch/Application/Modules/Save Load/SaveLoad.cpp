@@ -1,14 +1,14 @@
 #include "PrecompiledHeader.hpp"
 #include "Application\Application.hpp"
+#include "Application\Threading\WorkerThread.hpp"
+#include "SaveLoadSignatures.hpp"
+#include "VertexFile.hpp"
+#include "VertexJournal.hpp"
+#include "VertexText.hpp"
 
 namespace
 {
-	struct Vector3
-	{
-		float X;
-		float Y;
-		float Z;
-	};
+	using Vector3 = HAP::Vector3;
 
 	struct PlaneWinding
 	{
@@ -31,13 +31,20 @@ namespace
 			Close();
 		}
 
-		void Close()
+		/*
+			False if buffered data could not be written out.
+		*/
+		bool Close()
 		{
+			auto ret = true;
+
 			if (Handle)
 			{
-				fclose(Handle);
+				ret = fclose(Handle) == 0;
 				Handle = nullptr;
 			}
+
+			return ret;
 		}
 
 		auto Get() const
@@ -58,245 +65,197 @@ namespace
 			return Handle != nullptr;
 		}
 
-		template <typename... Types>
-		bool WriteSimple(Types&&... args)
-		{
-			size_t adder[] =
-			{
-				[&]()
-				{
-					return fwrite(&args, sizeof(args), 1, Get());
-				}()...
-			};
-
-			for (auto value : adder)
-			{
-				if (value == 0)
-				{
-					return false;
-				}
-			}
-
-			return true;
-		}
-
-		size_t WriteRegion(void* start, size_t size, int count = 1)
+		size_t WriteRegion(const void* start, size_t size, int count = 1)
 		{
 			return fwrite(start, size, count, Get());
 		}
 
-		template <typename... Args>
-		int WriteText(const char* format, Args&&... args)
-		{
-			return fprintf_s(Get(), format, std::forward<Args>(args)...);
-		}
-
-		template <typename... Types>
-		bool ReadSimple(Types&... args)
+		/*
+			One write per block.
+		*/
+		bool WriteBuffer(const HAP::ArenaBuffer& buffer)
 		{
-			size_t adder[] =
-			{
-				[&]()
-				{
-					return fread_s(&args, sizeof(args), sizeof(args), 1, Get());
-				}()...
-			};
-
-			for (auto value : adder)
+			return buffer.ForEachBlock([&](const uint8_t* data, size_t size)
 			{
-				if (value == 0)
-				{
-					return false;
-				}
-			}
-
-			return true;
-		}
-
-		template <typename T>
-		size_t ReadRegion(std::vector<T>& vec, int count = 1)
-		{
-			return fread_s(&vec[0], vec.size() * sizeof(T), sizeof(T), count, Get());
-		}
-
-		void SeekAbsolute(size_t pos)
-		{
-			fseek(Get(), pos, SEEK_SET);
+				return WriteRegion(data, size) == 1;
+			});
 		}
 
 		FILE* Handle = nullptr;
 	};
 
+	/*
+		Structure offsets that are captured from the signatures. The defaults
+		are the static offsets from May 8 2017 and are only used if a pattern
+		does not provide one.
+	*/
+	struct
+	{
+		int32_t FacePoints = 340;
+		int32_t FacePointCount = 344;
+		int32_t FaceID = 412;
+	} CapturedOffsets;
+
 	struct MapFace
 	{
 		static Vector3* GetPointsPtr(void* thisptr)
 		{
-			/*
-				Static structure offset May 8 2017
-			*/
 			HAP::StructureWalker walker(thisptr);
-			auto ret = *(Vector3**)walker.Advance(340);
+			auto ret = *(Vector3**)walker.Advance(CapturedOffsets.FacePoints);
 
 			return ret;
 		}
 
 		static int GetPointCount(void* thisptr)
 		{
-			/*
-				Static structure offset May 8 2017
-			*/
 			HAP::StructureWalker walker(thisptr);
-			auto ret = *(int*)walker.Advance(344);
+			auto ret = *(int*)walker.Advance(CapturedOffsets.FacePointCount);
 
 			return ret;
 		}
 
 		static int GetFaceID(void* thisptr)
 		{
-			/*
-				Static structure offset May 8 2017
-			*/
 			HAP::StructureWalker walker(thisptr);
-			auto ret = *(int*)walker.Advance(412);
+			auto ret = *(int*)walker.Advance(CapturedOffsets.FaceID);
 			
 			return ret;
 		}
+	};
 
-		int ParentSolidID;
-		int ID;
-
-		std::vector<Vector3> Points;
+	/*
+		Solid structure offsets that no signature captures. Static for both
+		2013 May 8 2017 and CSGO August 27 2017.
+	*/
+	struct SolidOffsets
+	{
+		enum
+		{
+			ID = 164,
+		};
 	};
 
 	struct MapSolid
 	{
 		static int GetID(void* thisptr)
 		{
-			/*
-				Static structure offset May 8 2017
-			*/
 			HAP::StructureWalker walker(thisptr);
-			auto ret = *(int*)walker.Advance(164);
+			auto ret = *(int*)walker.Advance(SolidOffsets::ID);
 
 			return ret;
 		}
-
-		static int GetFaceCount(void* thisptr)
-		{
-			int offset = 0;
-
-			if (HAP::IsCSGO())
-			{
-				/*
-					Static CSGO structure offset August 27 2017
-				*/
-				offset = 564;
-			}
-
-			else
-			{
-				/*
-					Static 2013 structure offset May 8 2017
-				*/
-				offset = 556;
-			}
-
-			HAP::StructureWalker walker(thisptr);
-			auto ret = *(short*)walker.Advance(offset);
-
-			return ret;
-		}
-
-		int ID;
-		std::vector<MapFace> Faces;
 	};
 
 	struct VertexSharedData
 	{
-		struct
-		{
-			/*
-				This must always be the first 4 bytes.
-				Anything after can vary per version.
-			*/
-			int32_t FileVersion;
-
-			int NumberOfSolids;
-		} FileHeader;
-
+		char MapFileName[1024];
 		char VertexFileName[1024];
 
-		ScopedFile* VertFilePtr;
-
 		bool IsLoading = false;
 		bool IsSaving = false;
 	} SharedData;
 
+	/*
+		Everything is kept in memory while Hammer saves. Both files are written
+		by the save thread after Hammer is done, so the save itself returns
+		without waiting for any of it.
+	*/
 	struct VertexSaveData
 	{
-		enum
-		{
-			Version = 1
-		};
+		char MapFileName[1024];
+		char VertexFileName[1024];
+		char TextFileName[1024];
 
-		ScopedFile* TextFilePtr;
-	} SaveData;
+		HAP::VertexFile::Writer Vertices;
 
-	struct VertexLoadData
-	{
-		void LoadVertexFile(ScopedFile* fileptr)
+		/*
+			Refers to the records in "Vertices" once they are serialized.
+		*/
+		HAP::ArenaBuffer Binary;
+		HAP::ArenaBuffer Text;
+
+		void SetFileNames(const char* mapname)
 		{
-			Solids.clear();
+			strcpy_s(MapFileName, mapname);
 
-			int32_t fileversion;
-			fileptr->ReadSimple(fileversion);
+			strcpy_s(VertexFileName, mapname);
+			PathRenameExtensionA(VertexFileName, ".hpverts");
 
-			HAP::MessageNormal("Master version: %d\n", VertexSaveData::Version);
-			HAP::MessageNormal("Map version: %d\n", fileversion);
+			strcpy_s(TextFileName, mapname);
+			PathRenameExtensionA(TextFileName, ".hpvertstext");
+		}
 
-			fileptr->SeekAbsolute(0);
-			fileptr->ReadSimple(SharedData.FileHeader);
+		bool WriteFiles();
+		bool WriteVertexFile();
 
-			Solids.resize(SharedData.FileHeader.NumberOfSolids);
+		/*
+			Compressed with "-hpcompress" on the command line.
+		*/
+		HAP::VertexFile::SectionEncoding Encoding = HAP::VertexFile::SectionEncoding::Raw;
 
-			for (auto& cursolid : Solids)
-			{
-				int facecount;
+		/*
+			Turned off with "-hpnotext", HammerPatchVertices can make the text file later.
+		*/
+		bool SaveText = true;
 
-				SharedData.VertFilePtr->ReadSimple(cursolid.ID, facecount);
-				cursolid.Faces.resize(facecount);
+		/*
+			Turned on with "-hpincremental", saves then only append the solids that
+			changed to the vertex file. Only used by the save thread and while loading.
+		*/
+		bool Incremental = false;
+		HAP::VertexFile::Journal Journal;
+	} SaveData;
 
-				for (auto& curface : cursolid.Faces)
-				{
-					int pointscount;
+	/*
+		Only one save is written at a time. It is waited for before the save data is
+		used again, before a map is loaded and before Hammer exits.
+	*/
+	HAP::WorkerThread SaveThread;
 
-					SharedData.VertFilePtr->ReadSimple(curface.ID, pointscount);
-					curface.Points.resize(pointscount);
+	/*
+		Reads the vertex file while Hammer parses the map.
+	*/
+	HAP::WorkerThread LoadThread;
 
-					SharedData.VertFilePtr->ReadRegion(curface.Points, pointscount);
+	struct VertexLoadData
+	{
+		/*
+			Files that were saved with a different version of the map are not used,
+			their faces would end up on the wrong solids.
+		*/
+		bool LoadVertexFile(const char* filename, const char* mapname)
+		{
+			auto res = File.OpenForMap(filename, mapname);
 
-					curface.ParentSolidID = cursolid.ID;
-				}
+			if (res != HAP::VertexFile::LoadStatus::Success)
+			{
+				HAP::MessageWarning("Could not load vertex file: %s\n", HAP::VertexFile::LoadStatusToString(res));
+				return false;
 			}
+
+			HAP::MessageNormal("Master version: %d\n", HAP::VertexFile::Version);
+			HAP::MessageNormal("Map version: %d\n", File.GetVersion());
+
+			return true;
 		}
 
-		MapFace* FindFaceByID(int id)
+		/*
+			Only waits for the load thread the first time, the
+			file is not touched by it anymore after that.
+		*/
+		void WaitUntilReady()
 		{
-			for (auto& solid : LoadData.Solids)
+			if (!IsReady)
 			{
-				for (auto& face : solid.Faces)
-				{
-					if (face.ID == id)
-					{
-						return &face;
-					}
-				}
+				LoadThread.Wait();
+				IsReady = true;
 			}
-
-			return nullptr;
 		}
 
-		std::vector<MapSolid> Solids;
+		HAP::VertexFile::MappedVertexFile File;
+		bool IsLoaded = false;
+
+		bool IsReady = false;
 	} LoadData;
 }
 
@@ -304,52 +263,64 @@ namespace
 {
 	namespace Module_MapDocLoad
 	{
-		/*
-			0x10097AC0 static 2013 Hammer IDA address May 8 2017
-			0x100A0B90 static CSGO Hammer IDA address August 27 2017
-		*/
-		auto Pattern2013 = "55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? A1 ?? ?? ?? ?? 85 C0 53 56 57 0F 94 C3 8B F9 40 88 5D F2 A3 ?? ?? ?? ?? 83 BF ?? ?? ?? ?? ?? 75 34 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 83 C4 04 89 45 EC C7 45 ?? ?? ?? ?? ?? 85 C0 74 0A 57 8B C8 E8 ?? ?? ?? ?? EB 02";
-		auto PatternCSGO = "55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? A1 ?? ?? ?? ?? 85 C0 53 8B D9 0F 94 C1 40 88 4D F2 56 A3 ?? ?? ?? ?? 83 BB ?? ?? ?? ?? ?? 75 37 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 83 C4 04 89 45 E8 C7 45 ?? ?? ?? ?? ?? 85 C0 74 0A 53 8B C8 E8 ?? ?? ?? ?? EB 02";
+		using namespace HAP::SaveLoadSignatures::MapDocLoad;
 
 		bool __fastcall Override(void* thisptr, void* edx, const char* filename, bool unk);
 
 		using ThisFunction = decltype(Override)*;
 
-		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapDocLoad", Override, []()
+		const HAP::BytePattern Patterns[] =
 		{
-			if (HAP::IsCSGO())
-			{
-				return PatternCSGO;
-			}
+			Pattern2013.Get(),
+			PatternCSGO.Get(),
+		};
 
-			return Pattern2013;
-		}());
+		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapDocLoad", Override, HAP::SelectForGame(Patterns));
 
 		bool __fastcall Override(void* thisptr, void* edx, const char* filename, bool unk)
 		{
+			/*
+				The map might have just been saved and its vertex file not be written yet.
+			*/
+			SaveThread.Wait();
+
 			SharedData.IsLoading = true;
 
+			strcpy_s(SharedData.MapFileName, filename);
+
 			strcpy_s(SharedData.VertexFileName, filename);
 			PathRenameExtensionA(SharedData.VertexFileName, ".hpverts");
 
-			ScopedFile file(SharedData.VertexFileName, "rb");
-			SharedData.VertFilePtr = &file;
+			/*
+				The file is read and decoded at the same time as Hammer parses the map.
+				Faces only wait for the chunk of the file they are in.
+			*/
+			LoadData.IsReady = false;
+			LoadData.File.BeginConcurrentLoad();
 
-			if (!file)
+			LoadThread.Run([]()
 			{
-				SharedData.VertFilePtr = nullptr;
+				LoadData.IsLoaded = LoadData.LoadVertexFile(SharedData.VertexFileName, SharedData.MapFileName);
+			});
 
-				HAP::MessageWarning("Could not open vertex file\n");
-			}
+			auto ret = ThisHook.GetOriginal()(thisptr, edx, filename, unk);
+
+			LoadData.WaitUntilReady();
 
-			else
+			if (SaveData.Incremental)
 			{
-				LoadData.LoadVertexFile(SharedData.VertFilePtr);
-			}
+				if (LoadData.IsLoaded)
+				{
+					SaveData.Journal.Assign(SharedData.VertexFileName, LoadData.File);
+				}
 
-			auto ret = ThisHook.GetOriginal()(thisptr, edx, filename, unk);
+				else
+				{
+					SaveData.Journal.Reset();
+				}
+			}
 
-			if (SharedData.VertFilePtr)
+			if (LoadData.IsLoaded)
 			{
 				char actualname[1024];
 				strcpy_s(actualname, filename);
@@ -359,13 +330,22 @@ namespace
 
 				HAP::MessageNormal("Loaded map \"%s\"\n", actualname);
 
-				/*
-					This memory is not used anymore
-				*/
-				LoadData.Solids.clear();
+				const auto& counters = LoadData.File.GetArena().GetCounters();
+				auto megabytes = [](size_t bytes)
+				{
+					return bytes / (1024.0 * 1024.0);
+				};
+
+				HAP::MessageNormal("Vertex data used %.1f MB at most in %zu allocations, %.1f MB peak with %.1f MB of file mapped\n", megabytes(counters.HighWaterMark), counters.Allocations, megabytes(counters.PeakBytes), megabytes(LoadData.File.GetMappedSize()));
 			}
 
-			SharedData.VertFilePtr = nullptr;
+			/*
+				This memory is not used anymore. Files that failed to load are
+				closed here as well, faces might have been copied from them.
+			*/
+			LoadData.File.Close();
+			LoadData.IsLoaded = false;
+
 			SharedData.IsLoading = false;
 
 			return ret;
@@ -374,80 +354,39 @@ namespace
 
 	namespace Module_MapDocSave
 	{
-		/*
-			0x100A36E0 static 2013 Hammer IDA address May 8 2017
-			0x100B3770 static CSGO Hammer IDA address August 27 2017
-		*/
-		auto Pattern2013 = "55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? 53 56 57 8B F9 8D 8D ?? ?? ?? ?? E8 ?? ?? ?? ?? C7 45 ?? ?? ?? ?? ?? 8D 8D ?? ?? ?? ?? 8B 5D 08 6A 01 53 E8 ?? ?? ?? ?? 8B CF 8B F0 E8 ?? ?? ?? ?? 68 ?? ?? ?? ??";
-		auto PatternCSGO = "55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? 53 56 8B D9 8D 8D ?? ?? ?? ?? 57 89 5D E4 E8 ?? ?? ?? ?? C7 45 ?? ?? ?? ?? ?? 8B 75 08 68 ?? ?? ?? ?? 56 E8 ?? ?? ?? ?? 83 C4 08 89 85 ?? ?? ?? ?? 85 C0 75 05 8D 78 02 EB 0C C7 85 ?? ?? ?? ?? ?? ?? ?? ?? 33 FF 8B CB E8 ?? ?? ?? ?? 8B 0D ?? ?? ?? ?? 68 ?? ?? ?? ??";
+		using namespace HAP::SaveLoadSignatures::MapDocSave;
 
 		bool __fastcall Override(void* thisptr, void* edx, const char* filename, int saveflags);
 
 		using ThisFunction = decltype(Override)*;
 
-		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapDocSave", Override, []()
+		const HAP::BytePattern Patterns[] =
 		{
-			if (HAP::IsCSGO())
-			{
-				return PatternCSGO;
-			}
+			Pattern2013.Get(),
+			PatternCSGO.Get(),
+		};
 
-			return Pattern2013;
-		}());
+		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapDocSave", Override, HAP::SelectForGame(Patterns));
 
 		bool __fastcall Override(void* thisptr, void* edx, const char* filename, int saveflags)
 		{
-			SharedData.IsSaving = true;
+			SaveThread.Wait();
 
-			strcpy_s(SharedData.VertexFileName, filename);
-			PathRenameExtensionA(SharedData.VertexFileName, ".hpverts");
+			SaveData.Vertices.Clear();
+			SaveData.Text.Clear();
 
-			ScopedFile vertfile(SharedData.VertexFileName, "wb");
-			SharedData.VertFilePtr = &vertfile;
-
-			if (!vertfile)
-			{
-				SharedData.VertFilePtr = nullptr;
-
-				HAP::MessageWarning("Could not create vertex file\n");
-			}
-
-			char textfilename[1024];
-			strcpy_s(textfilename, filename);
-			PathRenameExtensionA(textfilename, ".hpvertstext");
-
-			ScopedFile textfile(textfilename, "wb");
-			SaveData.TextFilePtr = &textfile;
-
-			if (!textfile)
-			{
-				SaveData.TextFilePtr = nullptr;
-
-				HAP::MessageWarning("Could not create vertex text file\n");
-			}
+			SharedData.IsSaving = true;
 
-			if (vertfile)
-			{
-				/*
-					Reset the header fields, it all gets overwritten later.
-				*/
-				SharedData.FileHeader = {};
-				SharedData.FileHeader.FileVersion = VertexSaveData::Version;
+			auto ret = ThisHook.GetOriginal()(thisptr, edx, filename, saveflags);
 
-				vertfile.WriteSimple(SharedData.FileHeader);
-			}
+			SharedData.IsSaving = false;
 
-			auto ret = ThisHook.GetOriginal()(thisptr, edx, filename, saveflags);
+			SaveData.SetFileNames(filename);
 
-			if (vertfile)
+			SaveThread.Run([]()
 			{
-				vertfile.SeekAbsolute(0);
-				vertfile.WriteSimple(SharedData.FileHeader);
-			}
-
-			SaveData.TextFilePtr = nullptr;
-			SharedData.VertFilePtr = nullptr;
-			SharedData.IsSaving = false;
+				SaveData.WriteFiles();
+			});
 
 			return ret;
 		}
@@ -455,41 +394,31 @@ namespace
 
 	namespace Module_MapSolidSave
 	{
-		/*
-			0x10149C90 static 2013 Hammer IDA address May 8 2017
-			0x1017DC20 static CSGO Hammer IDA address August 27 2017
-		*/
-		auto Pattern2013 = "55 8B EC 83 EC 08 57 8B F9 8B 4D 0C 57 89 7D FC E8 ?? ?? ?? ?? 84 C0 75 09 33 C0 5F 8B E5 5D C2 08 00 80 BF ?? ?? ?? ?? ?? 53 8B 5D 08 75 14 68 ?? ?? ?? ?? 8B CB E8 ?? ?? ?? ?? 85 C0 0F 85 ?? ?? ?? ??";
-		auto PatternCSGO = "55 8B EC 83 EC 08 8B C1 8B 4D 0C 89 45 FC 80 39 00 74 11 F6 80 ?? ?? ?? ?? ?? 75 08 33 C0 8B E5 5D C2 08 00 F6 80 ?? ?? ?? ?? ?? 53 8B 5D 08 56 57 75 16 68 ?? ?? ?? ?? 8B CB E8 ?? ?? ?? ?? 8B F0 85 F6 0F 85 ?? ?? ?? ??";
+		using namespace HAP::SaveLoadSignatures::MapSolidSave;
 
 		int __fastcall Override(void* thisptr, void* edx, void* file, void* saveinfo);
 
 		using ThisFunction = decltype(Override)*;
 
-		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapSolidSave", Override, []()
+		const HAP::BytePattern Patterns[] =
 		{
-			if (HAP::IsCSGO())
-			{
-				return PatternCSGO;
-			}
+			Pattern2013.Get(),
+			PatternCSGO.Get(),
+		};
 
-			return Pattern2013;
-		}());
+		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapSolidSave", Override, HAP::SelectForGame(Patterns));
 
 		int __fastcall Override(void* thisptr, void* edx, void* file, void* saveinfo)
 		{
-			if (SharedData.VertFilePtr)
+			if (SharedData.IsSaving)
 			{
-				SharedData.FileHeader.NumberOfSolids++;
-
 				auto id = MapSolid::GetID(thisptr);
-				auto facecount = MapSolid::GetFaceCount(thisptr);
 
-				SharedData.VertFilePtr->WriteSimple(id, facecount);
+				SaveData.Vertices.AddSolid(id);
 
-				if (SaveData.TextFilePtr)
+				if (SaveData.SaveText)
 				{
-					SaveData.TextFilePtr->WriteText("solid id: %d\n", id);
+					HAP::VertexFile::Text::AppendSolid(SaveData.Text, id);
 				}
 			}
 
@@ -500,47 +429,52 @@ namespace
 
 	namespace Module_MapFaceCreateFaceFromWinding
 	{
-		/*
-			0x101302A0 static 2013 Hammer IDA address May 9 2017
-			0x10162D70 static CSGO Hammer IDA address August 27 2017
-		*/
-		auto Pattern2013 = "55 8B EC 51 53 56 57 8B F1 6A 00 89 75 FC E8 ?? ?? ?? ?? 8B 7D 08 83 C4 04 8B CE FF 37 E8 ?? ?? ?? ?? 33 DB 39 9E ?? ?? ?? ?? 7E 41 33 D2 8B FF 8B 47 04 43 8B 8E ?? ?? ?? ?? D9 04 02 D9 1C 0A 8B 47 04 8B 8E ?? ?? ?? ?? D9 44 10 04 D9 5C 11 04 8B 47 04 8B 8E ?? ?? ?? ?? D9 44 10 08 D9 5C 11 08 83 C2 0C 3B 9E ?? ?? ?? ?? 7C C3";
-		auto PatternCSGO = "55 8B EC 51 53 56 57 8B F9 89 7D FC FF 15 ?? ?? ?? ?? 8B 75 08 8B CF FF 05 ?? ?? ?? ?? D9 1D ?? ?? ?? ?? FF 36 E8 ?? ?? ?? ?? 33 DB 39 9F ?? ?? ?? ?? 7E 4B 33 D2 66 66 0F 1F 84 00 ?? ?? ?? ?? 8B 46 04 8D 52 0C 8B 8F ?? ?? ?? ?? 43 8B 44 02 F4 89 44 0A F4 8B 46 04 8B 8F ?? ?? ?? ?? 8B 44 02 F8 89 44 0A F8 8B 46 04 8B 8F ?? ?? ?? ?? 8B 44 02 FC 89 44 0A FC 3B 9F ?? ?? ?? ?? 7C C1";
+		using namespace HAP::SaveLoadSignatures::MapFaceCreateFaceFromWinding;
 
 		void __fastcall Override(void* thisptr, void* edx, PlaneWinding* winding, int flags);
 
 		using ThisFunction = decltype(Override)*;
 
-		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapFaceCreateFaceFromWinding", Override, []()
+		const HAP::BytePattern Patterns[] =
 		{
-			if (HAP::IsCSGO())
-			{
-				return PatternCSGO;
-			}
+			Pattern2013.Get(),
+			PatternCSGO.Get(),
+		};
 
-			return Pattern2013;
-		}());
+		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapFaceCreateFaceFromWinding", Override, HAP::SelectForGame(Patterns));
 
 		void __fastcall Override(void* thisptr, void* edx, PlaneWinding* winding, int flags)
 		{
-			if (SharedData.IsLoading && SharedData.VertFilePtr)
+			if (SharedData.IsLoading)
 			{
 				auto id = MapFace::GetFaceID(thisptr);
 
-				auto sourceface = LoadData.FindFaceByID(id);
+				/*
+					Only waits if the chunk of the file with this face is not decoded yet.
+				*/
+				auto sourceface = LoadData.File.FindFace(id);
 
 				if (sourceface)
 				{
-					auto size = sourceface->Points.size() * sizeof(Vector3);
-					std::memcpy(winding->Points, sourceface->Points.data(), size);
+					auto size = sourceface->PointCount * sizeof(Vector3);
+					std::memcpy(winding->Points, sourceface->Points, size);
+
+					flags = 0;
 				}
 
 				else
 				{
-					HAP::MessageWarning("No saved face with id %d\n", id);
-				}
+					/*
+						A missing face can also mean that the file did not load.
+					*/
+					LoadData.WaitUntilReady();
 
-				flags = 0;
+					if (LoadData.IsLoaded)
+					{
+						HAP::MessageWarning("No saved face with id %d\n", id);
+						flags = 0;
+					}
+				}
 			}
 
 			ThisHook.GetOriginal()(thisptr, edx, winding, flags);
@@ -549,47 +483,37 @@ namespace
 
 	namespace Module_MapFaceSave
 	{
-		/*
-			0x10135C30 static 2013 Hammer IDA address May 7 2017
-			0x10166350 static CSGO Hammer IDA address August 27 2017
-		*/
-		auto Pattern2013 = "55 8B EC 81 EC ?? ?? ?? ?? 56 57 8B F1 E8 ?? ?? ?? ?? 6A 00 8B CE E8 ?? ?? ?? ?? 85 C0 75 07 8B CE E8 ?? ?? ?? ?? 8B 7D 08 8B CF 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 85 C0 0F 85 ?? ?? ?? ?? FF B6 ?? ?? ?? ?? 8B CF 68 ?? ?? ?? ??";
-		auto PatternCSGO = "55 8B EC 83 E4 C0 81 EC ?? ?? ?? ?? 56 57 8B F1 E8 ?? ?? ?? ?? 6A 00 8B CE E8 ?? ?? ?? ?? 85 C0 75 07 8B CE E8 ?? ?? ?? ?? 8B 7D 08 8B CF 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 85 C0 0F 85 ?? ?? ?? ?? FF B6 ?? ?? ?? ?? 8D 44 24 3C 68 ?? ?? ?? ??";
+		using namespace HAP::SaveLoadSignatures::MapFaceSave;
 
 		int __fastcall Override(void* thisptr, void* edx, void* file, void* saveinfo);
 
 		using ThisFunction = decltype(Override)*;
 
-		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapFaceSave", Override, []()
+		const HAP::BytePattern Patterns[] =
 		{
-			if (HAP::IsCSGO())
-			{
-				return PatternCSGO;
-			}
+			Pattern2013.Get(),
+			PatternCSGO.Get(),
+		};
 
-			return Pattern2013;
-		}());
+		HAP::HookModuleMask<ThisFunction> ThisHook("hammer_dll.dll", "MapFaceSave", Override, HAP::SelectForGame(Patterns));
 
 		int __fastcall Override(void* thisptr, void* edx, void* file, void* saveinfo)
 		{
-			if (SharedData.VertFilePtr)
-			{				
+			if (SharedData.IsSaving)
+			{
 				auto pointsaddr = MapFace::GetPointsPtr(thisptr);
 				auto pointscount = MapFace::GetPointCount(thisptr);
 				auto faceid = MapFace::GetFaceID(thisptr);
 
-				SharedData.VertFilePtr->WriteSimple(faceid, pointscount);
-
-				SharedData.VertFilePtr->WriteRegion(pointsaddr, sizeof(Vector3), pointscount);
+				SaveData.Vertices.AddFace(faceid, pointsaddr, static_cast<uint32_t>(pointscount));
 
-				if (SaveData.TextFilePtr)
+				if (SaveData.SaveText)
 				{
-					SaveData.TextFilePtr->WriteText("\tface id: %d\n", faceid);
+					HAP::VertexFile::Text::AppendFace(SaveData.Text, faceid);
 
 					for (size_t i = 0; i < pointscount; i++)
 					{
-						auto vec = pointsaddr[i];
-						SaveData.TextFilePtr->WriteText("\t\t[%g %g %g]\n", vec.X, vec.Y, vec.Z);
+						HAP::VertexFile::Text::AppendPoint(SaveData.Text, pointsaddr[i]);
 					}
 				}
 			}
@@ -598,4 +522,212 @@ namespace
 			return ret;
 		}
 	}
+
+	namespace Module_ExitProcess
+	{
+		void __stdcall Override(UINT code);
+
+		using ThisFunction = decltype(Override)*;
+
+		HAP::HookModuleAPI<ThisFunction> ThisHook("kernel32.dll", "ExitProcess", "ExitProcess", Override);
+
+		/*
+			Other threads are terminated once the process starts exiting,
+			so a save that is still being written has to finish here.
+		*/
+		void __stdcall Override(UINT code)
+		{
+			SaveThread.Stop();
+
+			ThisHook.GetOriginal()(code);
+		}
+	}
+}
+
+namespace
+{
+	/*
+		The file is written under a temporary name first, so a file that is only
+		partly written never replaces the previous one.
+	*/
+	bool PublishFile(const char* path, const HAP::ArenaBuffer& buffer)
+	{
+		char temppath[1024];
+		strcpy_s(temppath, path);
+		strcat_s(temppath, ".tmp");
+
+		ScopedFile file(temppath, "wb");
+
+		if (!file)
+		{
+			return false;
+		}
+
+		auto written = file.WriteBuffer(buffer);
+
+		if (!file.Close() || !written)
+		{
+			DeleteFileA(temppath);
+			return false;
+		}
+
+		if (!MoveFileExA(temppath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		{
+			DeleteFileA(temppath);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool VertexSaveData::WriteVertexFile()
+	{
+		if (!Incremental)
+		{
+			Vertices.Serialize(Binary, Encoding);
+			return PublishFile(VertexFileName, Binary);
+		}
+
+		auto update = Journal.Prepare(VertexFileName, Vertices, Encoding, Binary);
+
+		if (update == HAP::VertexFile::JournalUpdate::Unchanged)
+		{
+			return true;
+		}
+
+		if (update == HAP::VertexFile::JournalUpdate::Append)
+		{
+			if (Journal.Append(Binary))
+			{
+				HAP::MessageNormal("Saved %zu changed and %zu removed solids\n", Journal.GetChangedCount(), Journal.GetRemovedCount());
+				return true;
+			}
+
+			/*
+				The journal is reset now, so this is the whole file.
+			*/
+			Journal.Prepare(VertexFileName, Vertices, Encoding, Binary);
+		}
+
+		if (!PublishFile(VertexFileName, Binary))
+		{
+			Journal.Reset();
+			return false;
+		}
+
+		Journal.Commit(VertexFileName);
+		return true;
+	}
+
+	bool VertexSaveData::WriteFiles()
+	{
+		auto ret = true;
+
+		/*
+			Hammer is done writing the map, it is most likely still cached.
+		*/
+		HAP::VertexFile::MapFingerprint fingerprint;
+
+		if (HAP::VertexFile::ComputeMapFingerprint(MapFileName, fingerprint))
+		{
+			Vertices.SetMapFingerprint(fingerprint);
+		}
+
+		else
+		{
+			HAP::MessageWarning("Could not read map file, the vertex file will not be checked against it\n");
+		}
+
+		if (!WriteVertexFile())
+		{
+			HAP::MessageWarning("Could not write vertex file\n");
+			ret = false;
+		}
+
+		if (SaveText)
+		{
+			if (!PublishFile(TextFileName, Text))
+			{
+				HAP::MessageWarning("Could not write vertex text file\n");
+				ret = false;
+			}
+		}
+
+		else
+		{
+			/*
+				A text file from an earlier save would not match anymore.
+			*/
+			DeleteFileA(TextFileName);
+		}
+
+		/*
+			This memory is not used anymore, the binary data refers to the vertices
+		*/
+		Binary.Clear();
+		Vertices.Clear();
+		Text.Clear();
+
+		return ret;
+	}
+}
+
+namespace
+{
+	void UpdateOffset(const HAP::HookModuleBase& module, const char* name, int32_t& offset)
+	{
+		int32_t value;
+
+		if (!module.GetCapture(name, value))
+		{
+			HAP::MessageWarning("No capture \"%s\" in \"%s\", using static offset %d\n", name, module.DisplayName, offset);
+			return;
+		}
+
+		/*
+			Anything else means the pattern matched something unexpected.
+		*/
+		if (value <= 0 || value >= 4096 || value % 4 != 0)
+		{
+			HAP::MessageWarning("Capture \"%s\" in \"%s\" has unlikely value %d, using static offset %d\n", name, module.DisplayName, value, offset);
+			return;
+		}
+
+		offset = value;
+	}
+
+	/*
+		Startup procedures run after all modules are created so the captures are available.
+	*/
+	HAP::StartupFunctionAdder OffsetsStartup("SaveLoad structure offsets", []()
+	{
+		UpdateOffset(Module_MapFaceCreateFaceFromWinding::ThisHook, "Points", CapturedOffsets.FacePoints);
+		UpdateOffset(Module_MapFaceCreateFaceFromWinding::ThisHook, "PointCount", CapturedOffsets.FacePointCount);
+		UpdateOffset(Module_MapFaceSave::ThisHook, "ID", CapturedOffsets.FaceID);
+
+		return true;
+	});
+
+	HAP::StartupFunctionAdder OptionsStartup("SaveLoad options", []()
+	{
+		if (HAP::HasCommandLineSwitch("-hpcompress"))
+		{
+			SaveData.Encoding = HAP::VertexFile::SectionEncoding::Compressed;
+			HAP::MessageNormal("Saving compressed vertex files\n");
+		}
+
+		if (HAP::HasCommandLineSwitch("-hpnotext"))
+		{
+			SaveData.SaveText = false;
+			HAP::MessageNormal("Not saving vertex text files\n");
+		}
+
+		if (HAP::HasCommandLineSwitch("-hpincremental"))
+		{
+			SaveData.Incremental = true;
+			HAP::MessageNormal("Saving vertex files incrementally\n");
+		}
+
+		return true;
+	});
 }
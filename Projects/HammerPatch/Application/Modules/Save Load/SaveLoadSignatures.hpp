@@ -0,0 +1,83 @@
+#pragma once
+#include "Application/Scanner/BytePattern.hpp"
+
+/*
+	Signatures of the functions hooked in SaveLoad.cpp. Kept separate so the
+	tools can check them against Hammer builds without the rest of the library.
+
+	Captures pick up structure offsets from the instructions that use them:
+	the point array and count of a face from CreateFaceFromWinding,
+	and the face ID from MapFace::Save where it is written out.
+*/
+namespace HAP
+{
+	namespace SaveLoadSignatures
+	{
+		namespace MapDocLoad
+		{
+			/*
+				0x10097AC0 static 2013 Hammer IDA address May 8 2017
+				0x100A0B90 static CSGO Hammer IDA address August 27 2017
+			*/
+			constexpr auto Pattern2013 = HAP::CompilePattern("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? A1 ?? ?? ?? ?? 85 C0 53 56 57 0F 94 C3 8B F9 40 88 5D F2 A3 ?? ?? ?? ?? 83 BF ?? ?? ?? ?? ?? 75 34 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 83 C4 04 89 45 EC C7 45 ?? ?? ?? ?? ?? 85 C0 74 0A 57 8B C8 E8 ?? ?? ?? ?? EB 02");
+			constexpr auto PatternCSGO = HAP::CompilePattern("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? A1 ?? ?? ?? ?? 85 C0 53 8B D9 0F 94 C1 40 88 4D F2 56 A3 ?? ?? ?? ?? 83 BB ?? ?? ?? ?? ?? 75 37 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 83 C4 04 89 45 E8 C7 45 ?? ?? ?? ?? ?? 85 C0 74 0A 53 8B C8 E8 ?? ?? ?? ?? EB 02");
+		}
+
+		namespace MapDocSave
+		{
+			/*
+				0x100A36E0 static 2013 Hammer IDA address May 8 2017
+				0x100B3770 static CSGO Hammer IDA address August 27 2017
+			*/
+			constexpr auto Pattern2013 = HAP::CompilePattern("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? 53 56 57 8B F9 8D 8D ?? ?? ?? ?? E8 ?? ?? ?? ?? C7 45 ?? ?? ?? ?? ?? 8D 8D ?? ?? ?? ?? 8B 5D 08 6A 01 53 E8 ?? ?? ?? ?? 8B CF 8B F0 E8 ?? ?? ?? ?? 68 ?? ?? ?? ??");
+			constexpr auto PatternCSGO = HAP::CompilePattern("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 ?? ?? ?? ?? 50 64 89 25 ?? ?? ?? ?? 81 EC ?? ?? ?? ?? 53 56 8B D9 8D 8D ?? ?? ?? ?? 57 89 5D E4 E8 ?? ?? ?? ?? C7 45 ?? ?? ?? ?? ?? 8B 75 08 68 ?? ?? ?? ?? 56 E8 ?? ?? ?? ?? 83 C4 08 89 85 ?? ?? ?? ?? 85 C0 75 05 8D 78 02 EB 0C C7 85 ?? ?? ?? ?? ?? ?? ?? ?? 33 FF 8B CB E8 ?? ?? ?? ?? 8B 0D ?? ?? ?? ?? 68 ?? ?? ?? ??");
+		}
+
+		namespace MapSolidSave
+		{
+			/*
+				0x10149C90 static 2013 Hammer IDA address May 8 2017
+				0x1017DC20 static CSGO Hammer IDA address August 27 2017
+			*/
+			constexpr auto Pattern2013 = HAP::CompilePattern("55 8B EC 83 EC 08 57 8B F9 8B 4D 0C 57 89 7D FC E8 ?? ?? ?? ?? 84 C0 75 09 33 C0 5F 8B E5 5D C2 08 00 80 BF ?? ?? ?? ?? ?? 53 8B 5D 08 75 14 68 ?? ?? ?? ?? 8B CB E8 ?? ?? ?? ?? 85 C0 0F 85 ?? ?? ?? ??");
+			constexpr auto PatternCSGO = HAP::CompilePattern("55 8B EC 83 EC 08 8B C1 8B 4D 0C 89 45 FC 80 39 00 74 11 F6 80 ?? ?? ?? ?? ?? 75 08 33 C0 8B E5 5D C2 08 00 F6 80 ?? ?? ?? ?? ?? 53 8B 5D 08 56 57 75 16 68 ?? ?? ?? ?? 8B CB E8 ?? ?? ?? ?? 8B F0 85 F6 0F 85 ?? ?? ?? ??");
+		}
+
+		namespace MapFaceCreateFaceFromWinding
+		{
+			/*
+				0x101302A0 static 2013 Hammer IDA address May 9 2017
+				0x10162D70 static CSGO Hammer IDA address August 27 2017
+			*/
+			constexpr auto Pattern2013 = HAP::CompilePattern("55 8B EC 51 53 56 57 8B F1 6A 00 89 75 FC E8 ?? ?? ?? ?? 8B 7D 08 83 C4 04 8B CE FF 37 E8 ?? ?? ?? ?? 33 DB 39 9E {PointCount:4} 7E 41 33 D2 8B FF 8B 47 04 43 8B 8E {Points:4} D9 04 02 D9 1C 0A 8B 47 04 8B 8E ?? ?? ?? ?? D9 44 10 04 D9 5C 11 04 8B 47 04 8B 8E ?? ?? ?? ?? D9 44 10 08 D9 5C 11 08 83 C2 0C 3B 9E ?? ?? ?? ?? 7C C3");
+			constexpr auto PatternCSGO = HAP::CompilePattern("55 8B EC 51 53 56 57 8B F9 89 7D FC FF 15 ?? ?? ?? ?? 8B 75 08 8B CF FF 05 ?? ?? ?? ?? D9 1D ?? ?? ?? ?? FF 36 E8 ?? ?? ?? ?? 33 DB 39 9F {PointCount:4} 7E 4B 33 D2 66 66 0F 1F 84 00 ?? ?? ?? ?? 8B 46 04 8D 52 0C 8B 8F {Points:4} 43 8B 44 02 F4 89 44 0A F4 8B 46 04 8B 8F ?? ?? ?? ?? 8B 44 02 F8 89 44 0A F8 8B 46 04 8B 8F ?? ?? ?? ?? 8B 44 02 FC 89 44 0A FC 3B 9F ?? ?? ?? ?? 7C C1");
+		}
+
+		namespace MapFaceSave
+		{
+			/*
+				0x10135C30 static 2013 Hammer IDA address May 7 2017
+				0x10166350 static CSGO Hammer IDA address August 27 2017
+			*/
+			constexpr auto Pattern2013 = HAP::CompilePattern("55 8B EC 81 EC ?? ?? ?? ?? 56 57 8B F1 E8 ?? ?? ?? ?? 6A 00 8B CE E8 ?? ?? ?? ?? 85 C0 75 07 8B CE E8 ?? ?? ?? ?? 8B 7D 08 8B CF 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 85 C0 0F 85 ?? ?? ?? ?? FF B6 {ID:4} 8B CF 68 ?? ?? ?? ??");
+			constexpr auto PatternCSGO = HAP::CompilePattern("55 8B EC 83 E4 C0 81 EC ?? ?? ?? ?? 56 57 8B F1 E8 ?? ?? ?? ?? 6A 00 8B CE E8 ?? ?? ?? ?? 85 C0 75 07 8B CE E8 ?? ?? ?? ?? 8B 7D 08 8B CF 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 85 C0 0F 85 ?? ?? ?? ?? FF B6 {ID:4} 8D 44 24 3C 68 ?? ?? ?? ??");
+		}
+
+		inline std::vector<NamedPattern> GetAll()
+		{
+			return
+			{
+				{ "MapDocLoad", "2013", MapDocLoad::Pattern2013.Get() },
+				{ "MapDocLoad", "CSGO", MapDocLoad::PatternCSGO.Get() },
+				{ "MapDocSave", "2013", MapDocSave::Pattern2013.Get() },
+				{ "MapDocSave", "CSGO", MapDocSave::PatternCSGO.Get() },
+				{ "MapSolidSave", "2013", MapSolidSave::Pattern2013.Get() },
+				{ "MapSolidSave", "CSGO", MapSolidSave::PatternCSGO.Get() },
+				{ "MapFaceCreateFaceFromWinding", "2013", MapFaceCreateFaceFromWinding::Pattern2013.Get() },
+				{ "MapFaceCreateFaceFromWinding", "CSGO", MapFaceCreateFaceFromWinding::PatternCSGO.Get() },
+				{ "MapFaceSave", "2013", MapFaceSave::Pattern2013.Get() },
+				{ "MapFaceSave", "CSGO", MapFaceSave::PatternCSGO.Get() }
+			};
+		}
+	}
+}
@@ -0,0 +1,643 @@
+#include "VertexCodec.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	struct Reader
+	{
+		const uint8_t* Data;
+		size_t Size;
+		size_t Offset;
+
+		size_t GetRemaining() const
+		{
+			return Size - Offset;
+		}
+
+		template <typename T>
+		bool Read(T& value)
+		{
+			if (GetRemaining() < sizeof(T))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, Data + Offset, sizeof(T));
+			Offset += sizeof(T);
+
+			return true;
+		}
+
+		bool ReadVarint(uint32_t& value)
+		{
+			value = 0;
+
+			for (uint32_t shift = 0; shift < 35; shift += 7)
+			{
+				if (Offset == Size)
+				{
+					return false;
+				}
+
+				auto byte = Data[Offset++];
+				value |= uint32_t(byte & 0x7F) << shift;
+
+				if ((byte & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+	};
+
+	template <typename T>
+	void Append(std::vector<uint8_t>& output, const T& value)
+	{
+		auto bytes = reinterpret_cast<const uint8_t*>(&value);
+		output.insert(output.end(), bytes, bytes + sizeof(T));
+	}
+
+	void AppendVarint(std::vector<uint8_t>& output, uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			output.emplace_back(uint8_t(value | 0x80));
+			value >>= 7;
+		}
+
+		output.emplace_back(uint8_t(value));
+	}
+
+	/*
+		Small differences of either sign become small numbers.
+	*/
+	inline uint32_t ZigZag(uint32_t value)
+	{
+		return (value << 1) ^ (0 - (value >> 31));
+	}
+
+	inline uint32_t UnZigZag(uint32_t value)
+	{
+		return (value >> 1) ^ (0 - (value & 1));
+	}
+}
+
+namespace
+{
+	/*
+		Order 0 range asymmetric numeral system coder with byte wise renormalization.
+		Even and odd symbols use separate states so two decodes are in flight at once.
+	*/
+	namespace Entropy
+	{
+		enum : uint32_t
+		{
+			ProbabilityBits = 12,
+			ProbabilityScale = 1 << ProbabilityBits,
+
+			/*
+				Lower bound of the coder state, it stays in [StateLow, StateLow << 8).
+			*/
+			StateLow = 1 << 23,
+		};
+
+		enum class StreamMode : uint8_t
+		{
+			Stored,
+			Coded,
+		};
+
+		using FrequencyTable = uint32_t[256];
+
+		/*
+			Scales symbol counts so they add up to ProbabilityScale, with every symbol
+			that occurs keeping at least 1.
+		*/
+		void NormalizeFrequencies(const FrequencyTable& counts, size_t total, FrequencyTable& frequencies)
+		{
+			uint32_t sum = 0;
+			size_t largest = 0;
+
+			for (size_t i = 0; i < 256; i++)
+			{
+				frequencies[i] = 0;
+
+				if (counts[i] == 0)
+				{
+					continue;
+				}
+
+				auto frequency = static_cast<uint32_t>(uint64_t(counts[i]) * ProbabilityScale / total);
+				frequency = std::max(frequency, 1u);
+
+				frequencies[i] = frequency;
+				sum += frequency;
+
+				if (frequency > frequencies[largest])
+				{
+					largest = i;
+				}
+			}
+
+			/*
+				Rounding rare symbols up can overshoot, take it from the most common ones.
+			*/
+			while (sum > ProbabilityScale)
+			{
+				auto most = std::max_element(std::begin(frequencies), std::end(frequencies));
+				auto take = std::min(*most - 1, sum - ProbabilityScale);
+
+				*most -= take;
+				sum -= take;
+			}
+
+			frequencies[largest] += ProbabilityScale - sum;
+		}
+
+		void GetStarts(const FrequencyTable& frequencies, FrequencyTable& starts)
+		{
+			uint32_t start = 0;
+
+			for (size_t i = 0; i < 256; i++)
+			{
+				starts[i] = start;
+				start += frequencies[i];
+			}
+		}
+
+		/*
+			Streams that would not get smaller are stored as they are.
+		*/
+		void EncodeStream(const std::vector<uint8_t>& input, std::vector<uint8_t>& output)
+		{
+			Append(output, static_cast<uint32_t>(input.size()));
+
+			if (!input.empty())
+			{
+				FrequencyTable counts = {};
+
+				for (auto symbol : input)
+				{
+					counts[symbol]++;
+				}
+
+				FrequencyTable frequencies;
+				FrequencyTable starts;
+
+				NormalizeFrequencies(counts, input.size(), frequencies);
+				GetStarts(frequencies, starts);
+
+				/*
+					A symbol never takes more than 2 bytes, the states are written last.
+				*/
+				std::vector<uint8_t> coded(input.size() * 2 + sizeof(uint32_t) * 2);
+
+				auto end = coded.data() + coded.size();
+				auto ptr = end;
+
+				uint32_t states[2] = { StateLow, StateLow };
+
+				/*
+					Encoded back to front so the decoder can read front to back.
+				*/
+				for (size_t i = input.size(); i-- > 0;)
+				{
+					auto& state = states[i & 1];
+
+					auto symbol = input[i];
+					auto frequency = frequencies[symbol];
+
+					auto limit = ((StateLow >> ProbabilityBits) << 8) * frequency;
+
+					while (state >= limit)
+					{
+						*--ptr = uint8_t(state);
+						state >>= 8;
+					}
+
+					state = ((state / frequency) << ProbabilityBits) + (state % frequency) + starts[symbol];
+				}
+
+				ptr -= sizeof(states);
+				std::memcpy(ptr, states, sizeof(states));
+
+				auto codedsize = static_cast<size_t>(end - ptr);
+
+				if (codedsize + 256 * sizeof(uint16_t) + sizeof(uint32_t) < input.size())
+				{
+					output.emplace_back(uint8_t(StreamMode::Coded));
+
+					for (auto frequency : frequencies)
+					{
+						Append(output, static_cast<uint16_t>(frequency));
+					}
+
+					Append(output, static_cast<uint32_t>(codedsize));
+					output.insert(output.end(), ptr, end);
+
+					return;
+				}
+			}
+
+			output.emplace_back(uint8_t(StreamMode::Stored));
+			output.insert(output.end(), input.begin(), input.end());
+		}
+
+		/*
+			"maxsize" is the most the caller can use, anything larger is corrupt.
+		*/
+		bool DecodeStream(Reader& reader, size_t maxsize, std::vector<uint8_t>& output)
+		{
+			uint32_t size;
+			uint8_t mode;
+
+			if (!reader.Read(size) || !reader.Read(mode) || size > maxsize)
+			{
+				return false;
+			}
+
+			if (mode == uint8_t(StreamMode::Stored))
+			{
+				if (reader.GetRemaining() < size)
+				{
+					return false;
+				}
+
+				auto start = reader.Data + reader.Offset;
+				output.assign(start, start + size);
+
+				reader.Offset += size;
+				return true;
+			}
+
+			if (mode != uint8_t(StreamMode::Coded))
+			{
+				return false;
+			}
+
+			FrequencyTable frequencies;
+			uint32_t sum = 0;
+
+			for (auto& frequency : frequencies)
+			{
+				uint16_t value;
+
+				if (!reader.Read(value))
+				{
+					return false;
+				}
+
+				frequency = value;
+				sum += value;
+			}
+
+			if (sum != ProbabilityScale)
+			{
+				return false;
+			}
+
+			FrequencyTable starts;
+			GetStarts(frequencies, starts);
+
+			uint8_t symbols[ProbabilityScale];
+
+			for (size_t i = 0; i < 256; i++)
+			{
+				std::memset(symbols + starts[i], int(i), frequencies[i]);
+			}
+
+			uint32_t codedsize;
+
+			if (!reader.Read(codedsize) || codedsize < sizeof(uint32_t) * 2 || reader.GetRemaining() < codedsize)
+			{
+				return false;
+			}
+
+			auto ptr = reader.Data + reader.Offset;
+			auto end = ptr + codedsize;
+
+			reader.Offset += codedsize;
+
+			uint32_t states[2];
+			std::memcpy(states, ptr, sizeof(states));
+			ptr += sizeof(states);
+
+			output.resize(size);
+
+			auto decode = [&](uint32_t& state, uint8_t& value)
+			{
+				auto slot = state & (ProbabilityScale - 1);
+				auto symbol = symbols[slot];
+
+				value = symbol;
+				state = frequencies[symbol] * (state >> ProbabilityBits) + slot - starts[symbol];
+
+				while (state < StateLow)
+				{
+					if (ptr == end)
+					{
+						return false;
+					}
+
+					state = (state << 8) | *ptr++;
+				}
+
+				return true;
+			};
+
+			size_t i = 0;
+
+			for (; i + 1 < size; i += 2)
+			{
+				if (!decode(states[0], output[i]) || !decode(states[1], output[i + 1]))
+				{
+					return false;
+				}
+			}
+
+			if (i < size && !decode(states[0], output[i]))
+			{
+				return false;
+			}
+
+			/*
+				Decoding ends in the states encoding started with.
+			*/
+			return ptr == end && states[0] == StateLow && states[1] == StateLow;
+		}
+	}
+}
+
+namespace
+{
+	enum
+	{
+		/*
+			Points are compared against the ones before them up to this distance.
+		*/
+		MaxPointDistance = 255,
+
+		PointHashBits = 12,
+	};
+
+	inline uint32_t GetPointHash(const uint32_t(&bits)[3])
+	{
+		auto hash = (bits[0] * 0x9E3779B1u) ^ (bits[1] * 0x85EBCA77u) ^ (bits[2] * 0xC2B2AE3Du);
+		return hash >> (32 - PointHashBits);
+	}
+
+	/*
+		Only the bytes between the leading and trailing zero bytes of the difference are
+		kept. Values on the grid have trailing zeros and nearby values leading zeros.
+	*/
+	uint8_t EncodeResidual(uint32_t residual, std::vector<uint8_t>& bytes)
+	{
+		if (residual == 0)
+		{
+			return 0;
+		}
+
+		uint32_t low = 0;
+		uint32_t high = 0;
+
+		while (((residual >> (low * 8)) & 0xFF) == 0)
+		{
+			++low;
+		}
+
+		while (((residual >> ((3 - high) * 8)) & 0xFF) == 0)
+		{
+			++high;
+		}
+
+		for (auto i = low; i < 4 - high; i++)
+		{
+			bytes.emplace_back(uint8_t(residual >> (i * 8)));
+		}
+
+		return uint8_t(1 + high * 4 + low);
+	}
+
+	bool DecodeResidual(uint8_t code, const std::vector<uint8_t>& bytes, size_t& offset, uint32_t& residual)
+	{
+		residual = 0;
+
+		if (code == 0)
+		{
+			return true;
+		}
+
+		uint32_t high = (code - 1) / 4;
+		uint32_t low = (code - 1) % 4;
+
+		if (high + low > 3 || bytes.size() - offset < 4 - high - low)
+		{
+			return false;
+		}
+
+		for (auto i = low; i < 4 - high; i++)
+		{
+			residual |= uint32_t(bytes[offset++]) << (i * 8);
+		}
+
+		return true;
+	}
+}
+
+void HAP::VertexFile::Codec::EncodePoints(const Vector3* points, size_t count, std::vector<uint8_t>& output)
+{
+	std::vector<uint8_t> distances;
+	std::vector<uint8_t> codes;
+	std::vector<uint8_t> bytes;
+
+	distances.reserve(count);
+
+	/*
+		Block position + 1 of the last point with each hash.
+	*/
+	std::vector<uint32_t> recent(size_t(1) << PointHashBits, 0);
+
+	uint32_t previous[3] = {};
+
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t bits[3];
+		std::memcpy(bits, &points[i], sizeof(bits));
+
+		auto& entry = recent[GetPointHash(bits)];
+		auto candidate = entry;
+
+		entry = static_cast<uint32_t>(i + 1);
+
+		if (candidate != 0 && i + 1 - candidate <= MaxPointDistance && std::memcmp(&points[candidate - 1], bits, sizeof(bits)) == 0)
+		{
+			distances.emplace_back(uint8_t(i + 1 - candidate));
+		}
+
+		else
+		{
+			distances.emplace_back(0);
+
+			for (size_t j = 0; j < 3; j++)
+			{
+				codes.emplace_back(EncodeResidual(bits[j] ^ previous[j], bytes));
+			}
+		}
+
+		std::memcpy(previous, bits, sizeof(bits));
+	}
+
+	output.clear();
+
+	Entropy::EncodeStream(distances, output);
+	Entropy::EncodeStream(codes, output);
+	Entropy::EncodeStream(bytes, output);
+}
+
+bool HAP::VertexFile::Codec::DecodePoints(const uint8_t* data, size_t size, Vector3* points, size_t count)
+{
+	Reader reader = { data, size, 0 };
+
+	std::vector<uint8_t> distances;
+	std::vector<uint8_t> codes;
+	std::vector<uint8_t> bytes;
+
+	if (!Entropy::DecodeStream(reader, count, distances) ||
+		!Entropy::DecodeStream(reader, count * 3, codes) ||
+		!Entropy::DecodeStream(reader, count * 3 * 4, bytes))
+	{
+		return false;
+	}
+
+	if (distances.size() != count || reader.GetRemaining() != 0)
+	{
+		return false;
+	}
+
+	size_t codeoffset = 0;
+	size_t byteoffset = 0;
+
+	uint32_t previous[3] = {};
+
+	for (size_t i = 0; i < count; i++)
+	{
+		auto distance = distances[i];
+
+		if (distance != 0)
+		{
+			if (distance > i)
+			{
+				return false;
+			}
+
+			points[i] = points[i - distance];
+			std::memcpy(previous, &points[i], sizeof(previous));
+
+			continue;
+		}
+
+		if (codes.size() - codeoffset < 3)
+		{
+			return false;
+		}
+
+		for (size_t j = 0; j < 3; j++)
+		{
+			uint32_t residual;
+
+			if (!DecodeResidual(codes[codeoffset++], bytes, byteoffset, residual))
+			{
+				return false;
+			}
+
+			previous[j] ^= residual;
+		}
+
+		std::memcpy(&points[i], previous, sizeof(previous));
+	}
+
+	return codeoffset == codes.size() && byteoffset == bytes.size();
+}
+
+void HAP::VertexFile::Codec::EncodeFaces(const FaceRecord* faces, size_t count, std::vector<uint8_t>& output)
+{
+	std::vector<uint8_t> ids;
+	std::vector<uint8_t> firstpoints;
+	std::vector<uint8_t> pointcounts;
+
+	uint32_t previousid = 0;
+	uint32_t nextpoint = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const auto& face = faces[i];
+
+		auto id = static_cast<uint32_t>(face.ID);
+
+		AppendVarint(ids, ZigZag(id - previousid));
+		AppendVarint(firstpoints, ZigZag(face.FirstPoint - nextpoint));
+		AppendVarint(pointcounts, face.PointCount);
+
+		previousid = id;
+		nextpoint = face.FirstPoint + face.PointCount;
+	}
+
+	output.clear();
+
+	Entropy::EncodeStream(ids, output);
+	Entropy::EncodeStream(firstpoints, output);
+	Entropy::EncodeStream(pointcounts, output);
+}
+
+bool HAP::VertexFile::Codec::DecodeFaces(const uint8_t* data, size_t size, FaceRecord* faces, size_t count)
+{
+	Reader reader = { data, size, 0 };
+
+	std::vector<uint8_t> streams[3];
+
+	for (auto& stream : streams)
+	{
+		if (!Entropy::DecodeStream(reader, count * 5, stream))
+		{
+			return false;
+		}
+	}
+
+	if (reader.GetRemaining() != 0)
+	{
+		return false;
+	}
+
+	Reader ids = { streams[0].data(), streams[0].size(), 0 };
+	Reader firstpoints = { streams[1].data(), streams[1].size(), 0 };
+	Reader pointcounts = { streams[2].data(), streams[2].size(), 0 };
+
+	uint32_t previousid = 0;
+	uint32_t nextpoint = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t id;
+		uint32_t firstpoint;
+		uint32_t pointcount;
+
+		if (!ids.ReadVarint(id) || !firstpoints.ReadVarint(firstpoint) || !pointcounts.ReadVarint(pointcount))
+		{
+			return false;
+		}
+
+		auto& face = faces[i];
+		face.ID = static_cast<int32_t>(previousid + UnZigZag(id));
+		face.FirstPoint = nextpoint + UnZigZag(firstpoint);
+		face.PointCount = pointcount;
+
+		previousid = static_cast<uint32_t>(face.ID);
+		nextpoint = face.FirstPoint + face.PointCount;
+	}
+
+	return ids.GetRemaining() == 0 && firstpoints.GetRemaining() == 0 && pointcounts.GetRemaining() == 0;
+}
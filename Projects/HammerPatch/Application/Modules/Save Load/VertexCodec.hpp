@@ -0,0 +1,28 @@
+#pragma once
+#include "VertexFile.hpp"
+
+/*
+	Lossless compression for blocks of vertex file records.
+
+	Points are stored either as a copy of one of the previous 255 points of the block,
+	which is how corners shared between faces of a brush are found, or as the bitwise
+	difference to the point before them with zero bytes left out. Faces are stored as
+	variable length differences to the face before them. Each resulting byte stream
+	is then entropy coded on its own.
+
+	Blocks do not refer to each other so they can be coded in parallel.
+*/
+namespace HAP
+{
+	namespace VertexFile
+	{
+		namespace Codec
+		{
+			void EncodePoints(const Vector3* points, size_t count, std::vector<uint8_t>& output);
+			bool DecodePoints(const uint8_t* data, size_t size, Vector3* points, size_t count);
+
+			void EncodeFaces(const FaceRecord* faces, size_t count, std::vector<uint8_t>& output);
+			bool DecodeFaces(const uint8_t* data, size_t size, FaceRecord* faces, size_t count);
+		}
+	}
+}
@@ -0,0 +1,1902 @@
+#include "VertexFile.hpp"
+#include "VertexCodec.hpp"
+#include "Application/Memory/FastHash.hpp"
+#include "Application/Threading/RunChunks.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <unordered_map>
+
+namespace
+{
+	struct Reader
+	{
+		const uint8_t* Data;
+		size_t Size;
+		size_t Offset;
+
+		template <typename T>
+		bool Read(T& value)
+		{
+			if (Size - Offset < sizeof(T))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, Data + Offset, sizeof(T));
+			Offset += sizeof(T);
+
+			return true;
+		}
+
+		bool Skip(size_t count, size_t elementsize)
+		{
+			if (count > (Size - Offset) / elementsize)
+			{
+				return false;
+			}
+
+			Offset += count * elementsize;
+			return true;
+		}
+	};
+
+	/*
+		Goes through all solids and faces of a version 1 file. Without any
+		output it only counts the faces, so the arrays can be allocated once.
+	*/
+	bool WalkVersion1(const uint8_t* data, size_t size, size_t& facecount, HAP::ArenaVector<HAP::VertexFile::Solid>* solids, HAP::ArenaVector<HAP::VertexFile::Face>* faces)
+	{
+		Reader reader = { data, size, 0 };
+
+		int32_t fileversion;
+		int32_t solidcount;
+
+		if (!reader.Read(fileversion) || !reader.Read(solidcount) || solidcount < 0)
+		{
+			return false;
+		}
+
+		facecount = 0;
+
+		for (int32_t i = 0; i < solidcount; i++)
+		{
+			HAP::VertexFile::Solid solid;
+
+			int32_t solidfaces;
+
+			if (!reader.Read(solid.ID) || !reader.Read(solidfaces) || solidfaces < 0)
+			{
+				return false;
+			}
+
+			solid.FirstFace = static_cast<uint32_t>(facecount);
+			solid.FaceCount = static_cast<uint32_t>(solidfaces);
+
+			for (int32_t j = 0; j < solidfaces; j++)
+			{
+				HAP::VertexFile::Face face;
+
+				int32_t pointcount;
+
+				if (!reader.Read(face.ID) || !reader.Read(pointcount) || pointcount < 0)
+				{
+					return false;
+				}
+
+				face.SolidID = solid.ID;
+				face.PointCount = static_cast<uint32_t>(pointcount);
+				face.Points = reinterpret_cast<const HAP::Vector3*>(data + reader.Offset);
+
+				if (!reader.Skip(face.PointCount, sizeof(HAP::Vector3)))
+				{
+					return false;
+				}
+
+				if (faces)
+				{
+					faces->emplace_back(face);
+				}
+
+				++facecount;
+			}
+
+			if (solids)
+			{
+				solids->emplace_back(solid);
+			}
+		}
+
+		return true;
+	}
+
+	/*
+		Arena memory is not freed by clearing, the vector just has to stop referring to it.
+	*/
+	template <typename T>
+	void ReleaseVector(HAP::ArenaVector<T>& vector)
+	{
+		vector = HAP::ArenaVector<T>(vector.get_allocator());
+	}
+
+	struct SectionData
+	{
+		HAP::VertexFile::SectionEncoding Encoding = HAP::VertexFile::SectionEncoding::Raw;
+
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+	};
+
+	/*
+		Checks that a section is inside the file, a missing section has no data.
+	*/
+	bool FindSection(const uint8_t* data, size_t size, const HAP::VertexFile::FileHeader& header, HAP::VertexFile::SectionType type, SectionData& section)
+	{
+		auto sections = data + sizeof(header);
+
+		for (uint32_t i = 0; i < header.SectionCount; i++)
+		{
+			HAP::VertexFile::SectionEntry entry;
+			std::memcpy(&entry, sections + i * sizeof(entry), sizeof(entry));
+
+			if (entry.Type != type)
+			{
+				continue;
+			}
+
+			if (entry.Offset % 4 != 0 || entry.Offset > size || entry.Size > size - entry.Offset)
+			{
+				return false;
+			}
+
+			section.Encoding = entry.Encoding;
+			section.Data = data + entry.Offset;
+			section.Size = entry.Size;
+
+			return true;
+		}
+
+		section = {};
+		return true;
+	}
+
+	/*
+		Missing sections leave "found" as it was.
+	*/
+	bool ReadFingerprintSection(const SectionData& section, HAP::VertexFile::MapFingerprint& fingerprint, bool& found)
+	{
+		if (!section.Data)
+		{
+			return true;
+		}
+
+		if (section.Encoding != HAP::VertexFile::SectionEncoding::Raw || section.Size != sizeof(fingerprint))
+		{
+			return false;
+		}
+
+		std::memcpy(&fingerprint, section.Data, sizeof(fingerprint));
+		found = true;
+
+		return true;
+	}
+
+	/*
+		The fingerprint that loading the file ends up with, from the section tables alone.
+		Files of other versions have none, those are left for parsing to reject.
+	*/
+	bool FindMapFingerprint(const uint8_t* data, size_t size, HAP::VertexFile::MapFingerprint& fingerprint, bool& found)
+	{
+		using namespace HAP::VertexFile;
+
+		FileHeader header;
+
+		if (size < sizeof(header.FileVersion))
+		{
+			return false;
+		}
+
+		std::memcpy(&header.FileVersion, data, sizeof(header.FileVersion));
+
+		if (header.FileVersion != Version && header.FileVersion != JournaledVersion)
+		{
+			return true;
+		}
+
+		if (size < sizeof(header))
+		{
+			return false;
+		}
+
+		std::memcpy(&header, data, sizeof(header));
+
+		if (header.SectionCount > (size - sizeof(header)) / sizeof(SectionEntry))
+		{
+			return false;
+		}
+
+		SectionData section;
+
+		if (!FindSection(data, size, header, SectionType::MapFingerprint, section) || !ReadFingerprintSection(section, fingerprint, found))
+		{
+			return false;
+		}
+
+		if (header.FileVersion == Version)
+		{
+			return true;
+		}
+
+		if (!FindSection(data, size, header, SectionType::Journal, section))
+		{
+			return false;
+		}
+
+		Reader reader = { section.Data, section.Size, 0 };
+
+		while (reader.Offset < reader.Size)
+		{
+			uint32_t entrysize;
+
+			if (!reader.Read(entrysize) || entrysize % 4 != 0 || entrysize > reader.Size - reader.Offset)
+			{
+				return false;
+			}
+
+			int32_t entryversion;
+
+			if (entrysize < sizeof(entryversion))
+			{
+				return false;
+			}
+
+			std::memcpy(&entryversion, reader.Data + reader.Offset, sizeof(entryversion));
+
+			if (entryversion != Version || !FindMapFingerprint(reader.Data + reader.Offset, entrysize, fingerprint, found))
+			{
+				return false;
+			}
+
+			reader.Offset += entrysize;
+		}
+
+		return true;
+	}
+}
+
+const char* HAP::VertexFile::LoadStatusToString(LoadStatus status)
+{
+	static const char* table[] =
+	{
+		"Success",
+		"Could not open file",
+		"Unsupported file version",
+		"File is truncated or corrupt",
+		"Unsupported section encoding",
+		"File was not saved with this version of the map",
+	};
+
+	return table[static_cast<size_t>(status)];
+}
+
+HAP::VertexFile::MappedVertexFile::MappedVertexFile(MonotonicArena& arena) :
+	Arena(arena),
+	Solids(ArenaAllocator<Solid>(arena)),
+	Faces(ArenaAllocator<Face>(arena)),
+	DecodedFaces(ArenaAllocator<FaceRecord>(arena)),
+	DecodedPoints(ArenaAllocator<Vector3>(arena)),
+	RemovedSolids(ArenaAllocator<int32_t>(arena)),
+	FaceIndex(ArenaAllocator<uint32_t>(arena)),
+	ChunkFaceIndex(ArenaAllocator<FaceIndexRecord>(arena))
+{
+
+}
+
+bool HAP::VertexFile::ComputeMapFingerprint(const std::filesystem::path& path, MapFingerprint& output)
+{
+	std::error_code error;
+
+	auto size = std::filesystem::file_size(path, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	auto time = std::filesystem::last_write_time(path, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	output.Size = size;
+	output.WriteTime = static_cast<uint64_t>(time.time_since_epoch().count());
+	output.Hash = HAP::FastHash(nullptr, 0);
+
+	/*
+		Empty files cannot be mapped.
+	*/
+	if (size == 0)
+	{
+		return true;
+	}
+
+	MappedFile file;
+
+	if (!file.Open(path) || file.GetSize() != size)
+	{
+		return false;
+	}
+
+	output.Hash = HAP::FastHash(file.GetData(), file.GetSize());
+	return true;
+}
+
+bool HAP::VertexFile::MatchesMap(const MapFingerprint& fingerprint, const std::filesystem::path& path)
+{
+	std::error_code error;
+
+	auto size = std::filesystem::file_size(path, error);
+
+	if (error || size != fingerprint.Size)
+	{
+		return false;
+	}
+
+	auto time = std::filesystem::last_write_time(path, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	if (static_cast<uint64_t>(time.time_since_epoch().count()) == fingerprint.WriteTime)
+	{
+		return true;
+	}
+
+	MapFingerprint current;
+
+	return ComputeMapFingerprint(path, current) && current.Hash == fingerprint.Hash;
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::Open(const std::filesystem::path& path)
+{
+	return OpenFile(path, nullptr);
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::OpenForMap(const std::filesystem::path& path, const std::filesystem::path& mappath)
+{
+	return OpenFile(path, &mappath);
+}
+
+void HAP::VertexFile::MappedVertexFile::BeginConcurrentLoad()
+{
+	std::lock_guard<std::mutex> lock(Progress.Mutex);
+
+	Progress.Loading = true;
+	Progress.Planned = false;
+
+	Progress.ChunkFirstFaces.clear();
+	Progress.ChunkReady.clear();
+}
+
+void HAP::VertexFile::MappedVertexFile::EndConcurrentLoad()
+{
+	{
+		std::lock_guard<std::mutex> lock(Progress.Mutex);
+		Progress.Loading = false;
+	}
+
+	Progress.Signal.notify_all();
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::OpenFile(const std::filesystem::path& path, const std::filesystem::path* mappath)
+{
+	auto res = MapAndParse(path, mappath);
+
+	/*
+		Other threads might still use faces of a concurrent load.
+	*/
+	if (res != LoadStatus::Success && !Progress.Loading)
+	{
+		Close();
+	}
+
+	EndConcurrentLoad();
+
+	return res;
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::MapAndParse(const std::filesystem::path& path, const std::filesystem::path* mappath)
+{
+	Close();
+
+	Arena.ResetCounters();
+
+	if (!File.Open(path))
+	{
+		return LoadStatus::CouldNotOpen;
+	}
+
+	if (mappath)
+	{
+		MapFingerprint fingerprint;
+		auto found = false;
+
+		if (!FindMapFingerprint(File.GetData(), File.GetSize(), fingerprint, found))
+		{
+			return LoadStatus::Truncated;
+		}
+
+		if (found && !MatchesMap(fingerprint, *mappath))
+		{
+			return LoadStatus::StaleMap;
+		}
+	}
+
+	return Parse(File.GetData(), File.GetSize());
+}
+
+void HAP::VertexFile::MappedVertexFile::Close()
+{
+	ReleaseVector(Solids);
+	ReleaseVector(Faces);
+	ReleaseVector(FaceIndex);
+	ReleaseVector(ChunkFaceIndex);
+	ReleaseVector(DecodedFaces);
+	ReleaseVector(DecodedPoints);
+	ReleaseVector(RemovedSolids);
+
+	std::vector<std::unique_ptr<MappedVertexFile>>().swap(JournalEntries);
+
+	/*
+		Everything at once, this can be large.
+	*/
+	if (&Arena == &OwnArena)
+	{
+		OwnArena.Release();
+	}
+
+	FileVersion = 0;
+	SortedFaceIndex = nullptr;
+	HasFingerprint = false;
+
+	File.Close();
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::Parse(const void* data, size_t size)
+{
+	Solids.clear();
+	Faces.clear();
+	FaceIndex.clear();
+	ChunkFaceIndex.clear();
+	DecodedFaces.clear();
+	DecodedPoints.clear();
+	RemovedSolids.clear();
+	JournalEntries.clear();
+
+	SortedFaceIndex = nullptr;
+	HasFingerprint = false;
+
+	auto bytes = static_cast<const uint8_t*>(data);
+
+	/*
+		This must always be the first 4 bytes of every version.
+	*/
+	if (size < sizeof(FileVersion))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	std::memcpy(&FileVersion, bytes, sizeof(FileVersion));
+
+	switch (FileVersion)
+	{
+		case 1:
+		{
+			return ParseVersion1(bytes, size);
+		}
+
+		case 2:
+		{
+			return ParseVersion2(bytes, size, true);
+		}
+
+		case 3:
+		{
+			return ParseVersion3(bytes, size);
+		}
+	}
+
+	return LoadStatus::UnsupportedVersion;
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::ParseVersion1(const uint8_t* data, size_t size)
+{
+	size_t facecount;
+
+	if (!WalkVersion1(data, size, facecount, nullptr, nullptr))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	int32_t solidcount;
+	std::memcpy(&solidcount, data + sizeof(FileVersion), sizeof(solidcount));
+
+	Solids.reserve(solidcount);
+	Faces.reserve(facecount);
+
+	WalkVersion1(data, size, facecount, &Solids, &Faces);
+
+	BuildFaceIndex(nullptr);
+
+	return LoadStatus::Success;
+}
+
+namespace
+{
+	enum
+	{
+		/*
+			Smaller maps are decoded faster than threads can be started.
+		*/
+		FacesPerChunk = 32768,
+
+		PointsPerBlock = FacesPerChunk * 4,
+
+		/*
+			Compressed records take up almost no space when they repeat, this keeps
+			corrupt counts from allocating more than a 32 bit process can have.
+		*/
+		MaxCompressedRecords = 1 << 26,
+	};
+
+	template <typename T>
+	bool GetRawRecords(const SectionData& section, size_t count, const T*& records)
+	{
+		if (section.Size % sizeof(T) != 0 || section.Size / sizeof(T) != count)
+		{
+			return false;
+		}
+
+		records = reinterpret_cast<const T*>(section.Data);
+		return true;
+	}
+
+	struct CompressedBlock
+	{
+		const uint8_t* Data;
+		size_t Size;
+
+		size_t First;
+		size_t Count;
+	};
+
+	/*
+		Compressed sections start with the block count, then the record count
+		and size of every block, followed by the blocks.
+	*/
+	bool GetCompressedBlocks(const SectionData& section, size_t count, std::vector<CompressedBlock>& blocks)
+	{
+		Reader reader = { section.Data, section.Size, 0 };
+
+		uint32_t blockcount;
+
+		if (count > MaxCompressedRecords || !reader.Read(blockcount) || blockcount > reader.Size / (sizeof(uint32_t) * 2))
+		{
+			return false;
+		}
+
+		size_t first = 0;
+		size_t offset = reader.Offset + blockcount * sizeof(uint32_t) * 2;
+
+		for (uint32_t i = 0; i < blockcount; i++)
+		{
+			uint32_t recordcount;
+			uint32_t blocksize;
+
+			if (!reader.Read(recordcount) || !reader.Read(blocksize))
+			{
+				return false;
+			}
+
+			if (recordcount > count - first || offset > section.Size || blocksize > section.Size - offset)
+			{
+				return false;
+			}
+
+			CompressedBlock block;
+			block.Data = section.Data + offset;
+			block.Size = blocksize;
+			block.First = first;
+			block.Count = recordcount;
+
+			blocks.emplace_back(block);
+
+			first += recordcount;
+			offset += blocksize;
+		}
+
+		return first == count && offset == section.Size;
+	}
+
+	/*
+		Raw sections are used in place, compressed ones are split into "faceblocks" and
+		"pointblocks" that are later decoded into "decodedfaces" and "decodedpoints".
+	*/
+	HAP::VertexFile::LoadStatus GetFacesAndPoints(const HAP::VertexFile::FileHeader& header, const SectionData& facesection, const SectionData& pointsection, HAP::ArenaVector<HAP::VertexFile::FaceRecord>& decodedfaces, HAP::ArenaVector<HAP::Vector3>& decodedpoints, std::vector<CompressedBlock>& faceblocks, std::vector<CompressedBlock>& pointblocks, const HAP::VertexFile::FaceRecord*& facerecords, const HAP::Vector3*& points)
+	{
+		using namespace HAP::VertexFile;
+
+		switch (facesection.Encoding)
+		{
+			case SectionEncoding::Raw:
+			{
+				if (!GetRawRecords(facesection, header.FaceCount, facerecords))
+				{
+					return LoadStatus::Truncated;
+				}
+
+				break;
+			}
+
+			case SectionEncoding::Compressed:
+			{
+				if (!GetCompressedBlocks(facesection, header.FaceCount, faceblocks))
+				{
+					return LoadStatus::Truncated;
+				}
+
+				decodedfaces.resize(header.FaceCount);
+				facerecords = decodedfaces.data();
+
+				break;
+			}
+
+			default:
+			{
+				return LoadStatus::UnsupportedEncoding;
+			}
+		}
+
+		switch (pointsection.Encoding)
+		{
+			case SectionEncoding::Raw:
+			{
+				if (!GetRawRecords(pointsection, header.PointCount, points))
+				{
+					return LoadStatus::Truncated;
+				}
+
+				break;
+			}
+
+			case SectionEncoding::Compressed:
+			{
+				if (!GetCompressedBlocks(pointsection, header.PointCount, pointblocks))
+				{
+					return LoadStatus::Truncated;
+				}
+
+				decodedpoints.resize(header.PointCount);
+				points = decodedpoints.data();
+
+				break;
+			}
+
+			default:
+			{
+				return LoadStatus::UnsupportedEncoding;
+			}
+		}
+
+		return LoadStatus::Success;
+	}
+
+	/*
+		Blocks of a compressed section, each is decoded by the first chunk that needs it.
+		A chunk that needs a block another one is still decoding waits for it. That chunk
+		is running already and decoding never waits, so this cannot deadlock.
+	*/
+	class CompressedSection
+	{
+	public:
+		/*
+			Sections that are not compressed have no blocks.
+		*/
+		std::vector<CompressedBlock> Blocks;
+
+		void Start()
+		{
+			States.assign(Blocks.size(), Waiting);
+		}
+
+		/*
+			Decodes the blocks with records from "first" up to "last".
+			False if any block of the section was corrupt.
+		*/
+		template <typename Decoder>
+		bool DecodeRecords(size_t first, size_t last, Decoder&& decoder)
+		{
+			if (first >= last || Blocks.empty())
+			{
+				return true;
+			}
+
+			auto next = std::upper_bound(Blocks.begin(), Blocks.end(), first, [](size_t record, const CompressedBlock& block)
+			{
+				return record < block.First;
+			});
+
+			auto begin = static_cast<size_t>(next - Blocks.begin()) - 1;
+			auto end = begin;
+
+			while (end < Blocks.size() && Blocks[end].First < last)
+			{
+				++end;
+			}
+
+			return DecodeBlocks(begin, end, decoder);
+		}
+
+		template <typename Decoder>
+		bool DecodeBlocks(size_t begin, size_t end, Decoder&& decoder)
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+
+					if (States[i] != Waiting)
+					{
+						continue;
+					}
+
+					States[i] = Decoding;
+				}
+
+				auto valid = decoder(Blocks[i]);
+
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+
+					States[i] = Decoded;
+
+					if (!valid)
+					{
+						Valid = false;
+					}
+				}
+
+				Signal.notify_all();
+			}
+
+			std::unique_lock<std::mutex> lock(Mutex);
+
+			Signal.wait(lock, [&]()
+			{
+				return std::all_of(States.begin() + begin, States.begin() + end, [](uint8_t state)
+				{
+					return state == Decoded;
+				});
+			});
+
+			return Valid;
+		}
+
+	private:
+		enum : uint8_t
+		{
+			Waiting,
+			Decoding,
+			Decoded,
+		};
+
+		std::mutex Mutex;
+		std::condition_variable Signal;
+
+		std::vector<uint8_t> States;
+		bool Valid = true;
+	};
+
+	inline bool IsBefore(const HAP::VertexFile::FaceIndexRecord& left, const HAP::VertexFile::FaceIndexRecord& right)
+	{
+		if (left.ID != right.ID)
+		{
+			return left.ID < right.ID;
+		}
+
+		return left.Face < right.Face;
+	}
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::ParseVersion2(const uint8_t* data, size_t size, bool buildindex)
+{
+	FileHeader header;
+
+	if (size < sizeof(header))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	std::memcpy(&header, data, sizeof(header));
+
+	if (header.SectionCount > (size - sizeof(header)) / sizeof(SectionEntry))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	SectionData solidsection;
+	SectionData facesection;
+	SectionData indexsection;
+	SectionData pointsection;
+	SectionData removedsection;
+	SectionData fingerprintsection;
+
+	if (!FindSection(data, size, header, SectionType::Solids, solidsection) ||
+		!FindSection(data, size, header, SectionType::Faces, facesection) ||
+		!FindSection(data, size, header, SectionType::FaceIndex, indexsection) ||
+		!FindSection(data, size, header, SectionType::Points, pointsection) ||
+		!FindSection(data, size, header, SectionType::RemovedSolids, removedsection) ||
+		!FindSection(data, size, header, SectionType::MapFingerprint, fingerprintsection))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	/*
+		The index is optional, it is rebuilt from the faces if it is missing.
+	*/
+	if (!solidsection.Data || !facesection.Data || !pointsection.Data)
+	{
+		return LoadStatus::Truncated;
+	}
+
+	/*
+		Only faces and points are ever compressed.
+	*/
+	if (solidsection.Encoding != SectionEncoding::Raw || indexsection.Encoding != SectionEncoding::Raw || removedsection.Encoding != SectionEncoding::Raw)
+	{
+		return LoadStatus::UnsupportedEncoding;
+	}
+
+	if (removedsection.Size % sizeof(int32_t) != 0)
+	{
+		return LoadStatus::Truncated;
+	}
+
+	auto removed = reinterpret_cast<const int32_t*>(removedsection.Data);
+	RemovedSolids.assign(removed, removed + removedsection.Size / sizeof(int32_t));
+
+	if (!ReadFingerprintSection(fingerprintsection, Fingerprint, HasFingerprint))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	const SolidRecord* solidrecords;
+	const FaceIndexRecord* indexrecords = nullptr;
+
+	if (!GetRawRecords(solidsection, header.SolidCount, solidrecords))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	if (indexsection.Data && !GetRawRecords(indexsection, header.FaceCount, indexrecords))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	/*
+		Files of a single chunk, such as most journal entries, stay on this thread.
+	*/
+	auto workers = header.FaceCount <= FacesPerChunk ? size_t(1) : HAP::GetWorkerCount();
+
+	CompressedSection faceblocks;
+	CompressedSection pointblocks;
+
+	const FaceRecord* facerecords;
+	const Vector3* points;
+
+	auto res = GetFacesAndPoints(header, facesection, pointsection, DecodedFaces, DecodedPoints, faceblocks.Blocks, pointblocks.Blocks, facerecords, points);
+
+	if (res != LoadStatus::Success)
+	{
+		return res;
+	}
+
+	faceblocks.Start();
+	pointblocks.Start();
+
+	/*
+		Solids are few compared to faces, check them in order and
+		split their faces into chunks along the way.
+	*/
+	std::vector<uint32_t> chunkstarts;
+	std::vector<uint32_t> chunkfirstfaces;
+
+	Solids.resize(header.SolidCount);
+
+	uint32_t nextface = 0;
+	uint32_t chunkfaces = 0;
+
+	for (uint32_t i = 0; i < header.SolidCount; i++)
+	{
+		const auto& record = solidrecords[i];
+
+		if (record.FirstFace != nextface || record.FaceCount > header.FaceCount - nextface)
+		{
+			Solids.clear();
+			return LoadStatus::Truncated;
+		}
+
+		if (i == 0 || chunkfaces >= FacesPerChunk)
+		{
+			chunkstarts.emplace_back(i);
+			chunkfirstfaces.emplace_back(record.FirstFace);
+
+			chunkfaces = 0;
+		}
+
+		Solids[i].ID = record.ID;
+		Solids[i].FirstFace = record.FirstFace;
+		Solids[i].FaceCount = record.FaceCount;
+
+		nextface += record.FaceCount;
+		chunkfaces += record.FaceCount;
+	}
+
+	if (nextface != header.FaceCount)
+	{
+		Solids.clear();
+		return LoadStatus::Truncated;
+	}
+
+	chunkstarts.emplace_back(header.SolidCount);
+	chunkfirstfaces.emplace_back(header.FaceCount);
+
+	Faces.resize(header.FaceCount);
+
+	SortedFaceIndex = indexrecords;
+
+	auto solidchunks = chunkstarts.size() - 1;
+	auto indexchunks = indexrecords ? (size_t(header.FaceCount) + FacesPerChunk - 1) / FacesPerChunk : 0;
+
+	/*
+		Faces of journaled files are only known once the journal is applied,
+		those can not be looked up before they are done.
+	*/
+	auto publish = buildindex && Progress.Loading;
+
+	if (publish)
+	{
+		if (!SortedFaceIndex)
+		{
+			ChunkFaceIndex.resize(header.FaceCount);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(Progress.Mutex);
+
+			Progress.ChunkFirstFaces = chunkfirstfaces;
+			Progress.ChunkReady.assign(solidchunks, 0);
+			Progress.Planned = true;
+		}
+
+		Progress.Signal.notify_all();
+	}
+
+	auto decodefaces = [&](const CompressedBlock& block)
+	{
+		return Codec::DecodeFaces(block.Data, block.Size, DecodedFaces.data() + block.First, block.Count);
+	};
+
+	auto decodepoints = [&](const CompressedBlock& block)
+	{
+		return Codec::DecodePoints(block.Data, block.Size, DecodedPoints.data() + block.First, block.Count);
+	};
+
+	std::atomic<bool> valid(true);
+
+	/*
+		Solid chunks decode the blocks they need and fill in their faces, index chunks
+		check that the index is sorted and refers to faces with the same ID. Blocks
+		that no chunk needed are decoded last so that every one of them is checked.
+	*/
+	auto jobcount = solidchunks + indexchunks + faceblocks.Blocks.size() + pointblocks.Blocks.size();
+
+	HAP::RunChunks(jobcount, workers, [&](size_t chunk)
+	{
+		if (chunk < solidchunks)
+		{
+			auto firstface = chunkfirstfaces[chunk];
+			auto lastface = chunkfirstfaces[chunk + 1];
+
+			if (!faceblocks.DecodeRecords(firstface, lastface, decodefaces))
+			{
+				valid = false;
+				return;
+			}
+
+			/*
+				Only the points that the faces of the chunk refer to have to be decoded.
+			*/
+			size_t firstpoint = header.PointCount;
+			size_t lastpoint = 0;
+
+			for (auto j = firstface; j < lastface; j++)
+			{
+				const auto& record = facerecords[j];
+
+				if (record.FirstPoint > header.PointCount || record.PointCount > header.PointCount - record.FirstPoint)
+				{
+					valid = false;
+					return;
+				}
+
+				firstpoint = std::min<size_t>(firstpoint, record.FirstPoint);
+				lastpoint = std::max<size_t>(lastpoint, record.FirstPoint + record.PointCount);
+			}
+
+			if (!pointblocks.DecodeRecords(firstpoint, lastpoint, decodepoints))
+			{
+				valid = false;
+				return;
+			}
+
+			for (auto i = chunkstarts[chunk]; i < chunkstarts[chunk + 1]; i++)
+			{
+				const auto& solid = Solids[i];
+
+				for (auto j = solid.FirstFace; j < solid.FirstFace + solid.FaceCount; j++)
+				{
+					const auto& record = facerecords[j];
+
+					auto& face = Faces[j];
+					face.ID = record.ID;
+					face.SolidID = solid.ID;
+					face.PointCount = record.PointCount;
+					face.Points = points + record.FirstPoint;
+				}
+			}
+
+			if (!publish)
+			{
+				return;
+			}
+
+			if (!SortedFaceIndex)
+			{
+				auto index = ChunkFaceIndex.data();
+
+				for (auto j = firstface; j < lastface; j++)
+				{
+					index[j].ID = Faces[j].ID;
+					index[j].Face = j;
+				}
+
+				std::sort(index + firstface, index + lastface, IsBefore);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(Progress.Mutex);
+				Progress.ChunkReady[chunk] = 1;
+			}
+
+			Progress.Signal.notify_all();
+
+			return;
+		}
+
+		if (chunk < solidchunks + indexchunks)
+		{
+			/*
+				The index can refer to any face.
+			*/
+			if (!faceblocks.DecodeRecords(0, header.FaceCount, decodefaces))
+			{
+				valid = false;
+				return;
+			}
+
+			auto first = (chunk - solidchunks) * FacesPerChunk;
+			auto last = std::min<size_t>(first + FacesPerChunk, header.FaceCount);
+
+			for (auto i = first; i < last; i++)
+			{
+				const auto& record = indexrecords[i];
+
+				if (record.Face >= header.FaceCount || facerecords[record.Face].ID != record.ID)
+				{
+					valid = false;
+					return;
+				}
+
+				if (i > 0 && !IsBefore(indexrecords[i - 1], record))
+				{
+					valid = false;
+					return;
+				}
+			}
+
+			return;
+		}
+
+		auto block = chunk - solidchunks - indexchunks;
+
+		if (block < faceblocks.Blocks.size())
+		{
+			if (!faceblocks.DecodeBlocks(block, block + 1, decodefaces))
+			{
+				valid = false;
+			}
+
+			return;
+		}
+
+		block -= faceblocks.Blocks.size();
+
+		if (!pointblocks.DecodeBlocks(block, block + 1, decodepoints))
+		{
+			valid = false;
+		}
+	});
+
+	if (!valid)
+	{
+		/*
+			Faces that were looked up while loading stay in place until the file is closed.
+		*/
+		if (!publish)
+		{
+			Solids.clear();
+			Faces.clear();
+		}
+
+		return LoadStatus::Truncated;
+	}
+
+	if (buildindex)
+	{
+		BuildFaceIndex(SortedFaceIndex);
+	}
+
+	return LoadStatus::Success;
+}
+
+HAP::VertexFile::LoadStatus HAP::VertexFile::MappedVertexFile::ParseVersion3(const uint8_t* data, size_t size)
+{
+	/*
+		The index is built once the journal is applied.
+	*/
+	auto res = ParseVersion2(data, size, false);
+
+	if (res != LoadStatus::Success)
+	{
+		return res;
+	}
+
+	FileHeader header;
+	std::memcpy(&header, data, sizeof(header));
+
+	SectionData journal;
+
+	if (!FindSection(data, size, header, SectionType::Journal, journal))
+	{
+		return LoadStatus::Truncated;
+	}
+
+	Reader reader = { journal.Data, journal.Size, 0 };
+
+	while (reader.Offset < reader.Size)
+	{
+		uint32_t entrysize;
+
+		if (!reader.Read(entrysize) || entrysize % 4 != 0 || entrysize > reader.Size - reader.Offset)
+		{
+			return LoadStatus::Truncated;
+		}
+
+		auto entry = std::make_unique<MappedVertexFile>(Arena);
+		auto entrydata = reader.Data + reader.Offset;
+
+		if (entrysize < sizeof(entry->FileVersion))
+		{
+			return LoadStatus::Truncated;
+		}
+
+		std::memcpy(&entry->FileVersion, entrydata, sizeof(entry->FileVersion));
+
+		/*
+			Entries cannot have journals of their own.
+		*/
+		if (entry->FileVersion != Version)
+		{
+			return LoadStatus::Truncated;
+		}
+
+		/*
+			Only the solids and faces of entries are used, they get no index of their own.
+		*/
+		res = entry->ParseVersion2(entrydata, entrysize, false);
+
+		if (res != LoadStatus::Success)
+		{
+			return res;
+		}
+
+		if (entry->HasFingerprint)
+		{
+			Fingerprint = entry->Fingerprint;
+			HasFingerprint = true;
+		}
+
+		JournalEntries.emplace_back(std::move(entry));
+		reader.Offset += entrysize;
+	}
+
+	if (JournalEntries.empty())
+	{
+		BuildFaceIndex(SortedFaceIndex);
+	}
+
+	else
+	{
+		ApplyJournal();
+	}
+
+	return LoadStatus::Success;
+}
+
+void HAP::VertexFile::MappedVertexFile::ApplyJournal()
+{
+	/*
+		Where the solid that each ID ends up with comes from,
+		0 is this file and entries count from 1.
+	*/
+	using OwnerAllocator = ArenaAllocator<std::pair<const int32_t, size_t>>;
+
+	OwnerAllocator allocator(Arena);
+
+	std::unordered_map<int32_t, size_t, std::hash<int32_t>, std::equal_to<int32_t>, OwnerAllocator> owners(allocator);
+	owners.reserve(Solids.size());
+
+	for (const auto& solid : Solids)
+	{
+		owners[solid.ID] = 0;
+	}
+
+	for (size_t i = 0; i < JournalEntries.size(); i++)
+	{
+		const auto& entry = *JournalEntries[i];
+
+		for (auto id : entry.RemovedSolids)
+		{
+			owners.erase(id);
+		}
+
+		for (const auto& solid : entry.Solids)
+		{
+			owners[solid.ID] = i + 1;
+		}
+	}
+
+	/*
+		Goes through the solids that are kept, first only to count their faces
+		so the arrays do not have to grow.
+	*/
+	auto keep = [&](auto&& func)
+	{
+		for (size_t owner = 0; owner <= JournalEntries.size(); owner++)
+		{
+			const auto& source = owner == 0 ? *this : *JournalEntries[owner - 1];
+
+			for (const auto& solid : source.Solids)
+			{
+				auto it = owners.find(solid.ID);
+
+				if (it != owners.end() && it->second == owner)
+				{
+					func(source, solid);
+				}
+			}
+		}
+	};
+
+	size_t facecount = 0;
+
+	keep([&](const MappedVertexFile&, const Solid& solid)
+	{
+		facecount += solid.FaceCount;
+	});
+
+	ArenaVector<Solid> solids(Solids.get_allocator());
+	ArenaVector<Face> faces(Faces.get_allocator());
+
+	solids.reserve(owners.size());
+	faces.reserve(facecount);
+
+	keep([&](const MappedVertexFile& source, Solid solid)
+	{
+		auto first = source.Faces.begin() + solid.FirstFace;
+
+		solid.FirstFace = static_cast<uint32_t>(faces.size());
+		faces.insert(faces.end(), first, first + solid.FaceCount);
+
+		solids.emplace_back(solid);
+	});
+
+	Solids = std::move(solids);
+	Faces = std::move(faces);
+
+	BuildFaceIndex(nullptr);
+}
+
+namespace
+{
+	/*
+		Fibonacci hashing, face IDs are mostly sequential so the
+		high bits of the product spread them well.
+	*/
+	inline uint32_t GetFaceSlot(int32_t id, uint32_t shift)
+	{
+		return (static_cast<uint32_t>(id) * 0x9E3779B9u) >> shift;
+	}
+}
+
+void HAP::VertexFile::MappedVertexFile::BuildFaceIndex(const FaceIndexRecord* sorted)
+{
+	/*
+		At most half full so probe sequences stay short.
+	*/
+	uint32_t bits = 4;
+
+	while ((size_t(1) << bits) < Faces.size() * 2)
+	{
+		++bits;
+	}
+
+	FaceIndex.assign(size_t(1) << bits, 0);
+	FaceIndexShift = 32 - bits;
+
+	auto mask = static_cast<uint32_t>(FaceIndex.size() - 1);
+
+	/*
+		A sorted index has duplicate IDs next to each other with the first face
+		in front, so every ID only has to find a free slot.
+	*/
+	if (sorted)
+	{
+		for (size_t i = 0; i < Faces.size(); i++)
+		{
+			auto id = sorted[i].ID;
+
+			if (i > 0 && sorted[i - 1].ID == id)
+			{
+				continue;
+			}
+
+			auto slot = GetFaceSlot(id, FaceIndexShift);
+
+			while (FaceIndex[slot] != 0)
+			{
+				slot = (slot + 1) & mask;
+			}
+
+			FaceIndex[slot] = sorted[i].Face + 1;
+		}
+
+		return;
+	}
+
+	for (size_t i = 0; i < Faces.size(); i++)
+	{
+		auto id = Faces[i].ID;
+		auto slot = GetFaceSlot(id, FaceIndexShift);
+
+		while (true)
+		{
+			auto entry = FaceIndex[slot];
+
+			if (entry == 0)
+			{
+				FaceIndex[slot] = static_cast<uint32_t>(i + 1);
+				break;
+			}
+
+			if (Faces[entry - 1].ID == id)
+			{
+				break;
+			}
+
+			slot = (slot + 1) & mask;
+		}
+	}
+}
+
+const HAP::VertexFile::Face* HAP::VertexFile::MappedVertexFile::FindFace(int32_t id) const
+{
+	if (Progress.Loading)
+	{
+		return FindFaceWhileLoading(id);
+	}
+
+	if (FaceIndex.empty())
+	{
+		return nullptr;
+	}
+
+	auto mask = static_cast<uint32_t>(FaceIndex.size() - 1);
+	auto slot = GetFaceSlot(id, FaceIndexShift);
+
+	while (true)
+	{
+		auto entry = FaceIndex[slot];
+
+		if (entry == 0)
+		{
+			return nullptr;
+		}
+
+		const auto& face = Faces[entry - 1];
+
+		if (face.ID == id)
+		{
+			return &face;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+}
+
+const HAP::VertexFile::Face* HAP::VertexFile::MappedVertexFile::FindFaceWhileLoading(int32_t id) const
+{
+	std::unique_lock<std::mutex> lock(Progress.Mutex);
+
+	/*
+		Files that are not split into chunks are waited for until they are done.
+	*/
+	Progress.Signal.wait(lock, [&]()
+	{
+		return Progress.Planned || !Progress.Loading;
+	});
+
+	if (!Progress.Loading)
+	{
+		lock.unlock();
+		return FindFace(id);
+	}
+
+	const auto& firstfaces = Progress.ChunkFirstFaces;
+	auto facecount = firstfaces.back();
+
+	/*
+		False if the file failed before the chunk was done.
+	*/
+	auto waitforchunk = [&](size_t chunk)
+	{
+		Progress.Signal.wait(lock, [&]()
+		{
+			return Progress.ChunkReady[chunk] || !Progress.Loading;
+		});
+
+		return Progress.ChunkReady[chunk] != 0;
+	};
+
+	auto comparer = [](const FaceIndexRecord& record, int32_t value)
+	{
+		return record.ID < value;
+	};
+
+	/*
+		The index section is in the file from the start, it is only checked
+		against the faces later so its face numbers can be out of range.
+	*/
+	if (SortedFaceIndex)
+	{
+		auto end = SortedFaceIndex + facecount;
+		auto it = std::lower_bound(SortedFaceIndex, end, id, comparer);
+
+		if (it == end || it->ID != id || it->Face >= facecount)
+		{
+			return nullptr;
+		}
+
+		auto face = it->Face;
+		auto chunk = static_cast<size_t>(std::upper_bound(firstfaces.begin(), firstfaces.end(), face) - firstfaces.begin()) - 1;
+
+		if (!waitforchunk(chunk) || Faces[face].ID != id)
+		{
+			return nullptr;
+		}
+
+		return &Faces[face];
+	}
+
+	/*
+		Chunks in file order, so the first face with the ID is found. IDs mostly
+		go up through the file, so most chunks are ruled out by their first and last ID.
+	*/
+	for (size_t chunk = 0; chunk + 1 < firstfaces.size(); chunk++)
+	{
+		if (!waitforchunk(chunk))
+		{
+			return nullptr;
+		}
+
+		auto first = ChunkFaceIndex.data() + firstfaces[chunk];
+		auto last = ChunkFaceIndex.data() + firstfaces[chunk + 1];
+
+		if (first == last || id < first->ID || id > (last - 1)->ID)
+		{
+			continue;
+		}
+
+		auto it = std::lower_bound(first, last, id, comparer);
+
+		if (it != last && it->ID == id)
+		{
+			return &Faces[it->Face];
+		}
+	}
+
+	return nullptr;
+}
+
+namespace
+{
+	inline uint64_t HashFace(int32_t id, const HAP::Vector3* points, uint32_t count, uint64_t hash)
+	{
+		const uint32_t head[] = { static_cast<uint32_t>(id), count };
+
+		hash = HAP::FastHash(head, sizeof(head), hash);
+		return HAP::FastHash(points, count * sizeof(HAP::Vector3), hash);
+	}
+}
+
+uint64_t HAP::VertexFile::MappedVertexFile::GetSolidHash(size_t index) const
+{
+	const auto& solid = Solids[index];
+	uint64_t hash = 0;
+
+	for (auto i = solid.FirstFace; i < solid.FirstFace + solid.FaceCount; i++)
+	{
+		const auto& face = Faces[i];
+		hash = HashFace(face.ID, face.Points, face.PointCount, hash);
+	}
+
+	return hash;
+}
+
+void HAP::VertexFile::Writer::Clear()
+{
+	Solids.Clear();
+	Faces.Clear();
+	Points.Clear();
+	RemovedSolids.clear();
+
+	HasFingerprint = false;
+}
+
+void HAP::VertexFile::Writer::AddSolid(int32_t id)
+{
+	SolidRecord solid;
+	solid.ID = id;
+	solid.FirstFace = static_cast<uint32_t>(Faces.GetSize());
+	solid.FaceCount = 0;
+
+	Solids.Add(solid);
+}
+
+void HAP::VertexFile::Writer::AddFace(int32_t id, const Vector3* points, uint32_t count)
+{
+	/*
+		Faces are only saved as part of a solid.
+	*/
+	if (Solids.IsEmpty())
+	{
+		return;
+	}
+
+	FaceRecord face;
+	face.ID = id;
+	face.FirstPoint = static_cast<uint32_t>(Points.GetSize());
+	face.PointCount = count;
+
+	Faces.Add(face);
+	Points.Append(points, count);
+
+	Solids.Back().FaceCount++;
+}
+
+void HAP::VertexFile::Writer::CopySolid(const Writer& other, size_t index)
+{
+	const auto& solid = other.Solids[index];
+
+	AddSolid(solid.ID);
+
+	for (auto i = solid.FirstFace; i < solid.FirstFace + solid.FaceCount; i++)
+	{
+		auto face = other.Faces[i];
+
+		other.Points.ForEachRun(face.FirstPoint, face.PointCount, [&](const Vector3* points, size_t count)
+		{
+			Points.Append(points, count);
+		});
+
+		face.FirstPoint = static_cast<uint32_t>(Points.GetSize() - face.PointCount);
+
+		Faces.Add(face);
+		Solids.Back().FaceCount++;
+	}
+}
+
+void HAP::VertexFile::Writer::RemoveSolid(int32_t id)
+{
+	RemovedSolids.emplace_back(id);
+}
+
+void HAP::VertexFile::Writer::SetMapFingerprint(const MapFingerprint& fingerprint)
+{
+	Fingerprint = fingerprint;
+	HasFingerprint = true;
+}
+
+uint64_t HAP::VertexFile::Writer::GetSolidHash(size_t index) const
+{
+	const auto& solid = Solids[index];
+	uint64_t hash = 0;
+
+	std::vector<Vector3> scratch;
+
+	for (auto i = solid.FirstFace; i < solid.FirstFace + solid.FaceCount; i++)
+	{
+		const auto& face = Faces[i];
+		hash = HashFace(face.ID, Points.GetRange(face.FirstPoint, face.PointCount, scratch), face.PointCount, hash);
+	}
+
+	return hash;
+}
+
+void HAP::VertexFile::Writer::Append(const Writer& other)
+{
+	auto faceoffset = static_cast<uint32_t>(Faces.GetSize());
+	auto pointoffset = static_cast<uint32_t>(Points.GetSize());
+
+	other.Solids.ForEachRun(0, other.Solids.GetSize(), [&](const SolidRecord* solids, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			auto solid = solids[i];
+			solid.FirstFace += faceoffset;
+
+			Solids.Add(solid);
+		}
+	});
+
+	other.Faces.ForEachRun(0, other.Faces.GetSize(), [&](const FaceRecord* faces, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			auto face = faces[i];
+			face.FirstPoint += pointoffset;
+
+			Faces.Add(face);
+		}
+	});
+
+	other.Points.ForEachRun(0, other.Points.GetSize(), [&](const Vector3* points, size_t count)
+	{
+		Points.Append(points, count);
+	});
+}
+
+namespace
+{
+	/*
+		Blocks that cross a block of the records are put together in a copy first.
+	*/
+	template <typename T, typename Encoder>
+	void CompressRecords(const HAP::BlockVector<T>& records, size_t blocksize, Encoder encoder, std::vector<uint8_t>& output)
+	{
+		auto count = records.GetSize();
+		auto blockcount = (count + blocksize - 1) / blocksize;
+
+		std::vector<std::vector<uint8_t>> blocks(blockcount);
+
+		HAP::RunChunks(blockcount, HAP::GetWorkerCount(), [&](size_t index)
+		{
+			auto first = index * blocksize;
+			auto amount = std::min(blocksize, count - first);
+
+			std::vector<T> scratch;
+			encoder(records.GetRange(first, amount, scratch), amount, blocks[index]);
+		});
+
+		auto append = [&](uint32_t value)
+		{
+			auto bytes = reinterpret_cast<const uint8_t*>(&value);
+			output.insert(output.end(), bytes, bytes + sizeof(value));
+		};
+
+		output.clear();
+		append(static_cast<uint32_t>(blockcount));
+
+		for (size_t i = 0; i < blockcount; i++)
+		{
+			append(static_cast<uint32_t>(std::min(blocksize, count - i * blocksize)));
+			append(static_cast<uint32_t>(blocks[i].size()));
+		}
+
+		for (const auto& block : blocks)
+		{
+			output.insert(output.end(), block.begin(), block.end());
+		}
+	}
+}
+
+void HAP::VertexFile::Writer::Serialize(ArenaBuffer& output, SectionEncoding encoding, bool journaled) const
+{
+	/*
+		Sections that refer to records in blocks are put after the ones that are
+		copied, so all the small ones share the first block of the output.
+	*/
+	struct Payload
+	{
+		SectionType Type;
+		SectionEncoding Encoding;
+
+		const void* Data;
+		size_t Size;
+
+		/*
+			Refers to the records of this type instead of copying "Data".
+		*/
+		bool View;
+	};
+
+	static_assert(sizeof(SolidRecord) % 4 == 0 && sizeof(FaceRecord) % 4 == 0 && sizeof(Vector3) % 4 == 0, "Records have to keep sections aligned");
+
+	std::vector<Payload> payloads;
+
+	std::vector<FaceIndexRecord> index;
+	std::vector<uint8_t> compressedfaces;
+	std::vector<uint8_t> compressedpoints;
+
+	if (encoding == SectionEncoding::Compressed)
+	{
+		/*
+			The index is left out, it compresses poorly and is cheap to rebuild.
+		*/
+		CompressRecords(Faces, FacesPerChunk, Codec::EncodeFaces, compressedfaces);
+		CompressRecords(Points, PointsPerBlock, Codec::EncodePoints, compressedpoints);
+
+		payloads.push_back({ SectionType::Faces, encoding, compressedfaces.data(), compressedfaces.size(), false });
+		payloads.push_back({ SectionType::Points, encoding, compressedpoints.data(), compressedpoints.size(), false });
+	}
+
+	else
+	{
+		index.resize(Faces.GetSize());
+
+		for (size_t i = 0; i < Faces.GetSize(); i++)
+		{
+			index[i].ID = Faces[i].ID;
+			index[i].Face = static_cast<uint32_t>(i);
+		}
+
+		std::sort(index.begin(), index.end(), IsBefore);
+
+		payloads.push_back({ SectionType::FaceIndex, encoding, index.data(), index.size() * sizeof(FaceIndexRecord), false });
+	}
+
+	if (!RemovedSolids.empty())
+	{
+		payloads.push_back({ SectionType::RemovedSolids, SectionEncoding::Raw, RemovedSolids.data(), RemovedSolids.size() * sizeof(int32_t), false });
+	}
+
+	if (HasFingerprint)
+	{
+		payloads.push_back({ SectionType::MapFingerprint, SectionEncoding::Raw, &Fingerprint, sizeof(Fingerprint), false });
+	}
+
+	payloads.push_back({ SectionType::Solids, SectionEncoding::Raw, nullptr, Solids.GetSize() * sizeof(SolidRecord), true });
+
+	if (encoding == SectionEncoding::Raw)
+	{
+		payloads.push_back({ SectionType::Faces, encoding, nullptr, Faces.GetSize() * sizeof(FaceRecord), true });
+		payloads.push_back({ SectionType::Points, encoding, nullptr, Points.GetSize() * sizeof(Vector3), true });
+	}
+
+	/*
+		The journal has to be last so entries can be appended to the file.
+	*/
+	if (journaled)
+	{
+		payloads.push_back({ SectionType::Journal, SectionEncoding::Raw, nullptr, 0, false });
+	}
+
+	FileHeader header;
+	header.FileVersion = journaled ? JournaledVersion : Version;
+	header.SectionCount = static_cast<uint32_t>(payloads.size());
+	header.SolidCount = static_cast<uint32_t>(Solids.GetSize());
+	header.FaceCount = static_cast<uint32_t>(Faces.GetSize());
+	header.PointCount = static_cast<uint32_t>(Points.GetSize());
+
+	/*
+		Every section starts at a multiple of 4 bytes.
+	*/
+	auto getpadded = [](size_t size)
+	{
+		return (size + 3) & ~size_t(3);
+	};
+
+	std::vector<SectionEntry> sections;
+	auto offset = sizeof(header) + payloads.size() * sizeof(SectionEntry);
+
+	for (const auto& payload : payloads)
+	{
+		SectionEntry entry;
+		entry.Type = payload.Type;
+		entry.Encoding = payload.Encoding;
+		entry.Offset = static_cast<uint32_t>(offset);
+		entry.Size = static_cast<uint32_t>(payload.Size);
+
+		sections.emplace_back(entry);
+		offset += getpadded(payload.Size);
+	}
+
+	output.Clear();
+
+	output.Append(&header, sizeof(header));
+	output.Append(sections.data(), sections.size() * sizeof(SectionEntry));
+
+	auto appendview = [&](const auto& records)
+	{
+		records.ForEachRun(0, records.GetSize(), [&](const auto* data, size_t count)
+		{
+			output.AppendView(data, count * sizeof(*data));
+		});
+	};
+
+	for (const auto& payload : payloads)
+	{
+		if (!payload.View)
+		{
+			const uint8_t padding[4] = {};
+
+			output.Append(payload.Data, payload.Size);
+			output.Append(padding, getpadded(payload.Size) - payload.Size);
+
+			continue;
+		}
+
+		switch (payload.Type)
+		{
+			case SectionType::Solids:
+			{
+				appendview(Solids);
+				break;
+			}
+
+			case SectionType::Faces:
+			{
+				appendview(Faces);
+				break;
+			}
+
+			case SectionType::Points:
+			{
+				appendview(Points);
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,497 @@
+#pragma once
+#include "Application/Files/MappedFile.hpp"
+#include "Application/Memory/ArenaBuffer.hpp"
+#include "Application/Memory/BlockVector.hpp"
+#include "Application/Memory/MonotonicArena.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+	Reader for the .hpverts files written next to each map. Only depends on
+	the standard library so the tools can use it as well.
+*/
+namespace HAP
+{
+	struct Vector3
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	namespace VertexFile
+	{
+		enum
+		{
+			/*
+				Newest version, used when saving.
+			*/
+			Version = 2,
+
+			/*
+				Version 2 with a journal, used for incremental saves.
+			*/
+			JournaledVersion = 3,
+		};
+
+		/*
+			Version 1 layout:
+
+			int32 FileVersion
+			int32 NumberOfSolids
+
+			For each solid:
+				int32 ID
+				int32 FaceCount
+
+				For each face:
+					int32 ID
+					int32 PointCount
+					Vector3 Points[PointCount]
+		*/
+
+		/*
+			Version 2 layout:
+
+			FileHeader
+			SectionEntry Sections[SectionCount]
+
+			Followed by the sections in any order, at 4 byte aligned offsets
+			from the start of the file. Sections of unknown types are skipped.
+
+			Solids:		SolidRecord[SolidCount], in save order
+			Faces:		FaceRecord[FaceCount], grouped by solid
+			FaceIndex:	FaceIndexRecord[FaceCount], sorted by ID then face, optional
+			Points:		Vector3[PointCount]
+			MapFingerprint:	MapFingerprint, optional
+
+			Every record can be found without reading what comes before it,
+			so the sections can be decoded in parallel.
+
+			Compressed sections:
+
+			uint32 BlockCount
+			uint32 RecordCount, uint32 Size for each block
+			Followed by the blocks
+		*/
+
+		/*
+			Version 3 layout:
+
+			The version 2 layout, with the journal as the last section of the file.
+			It starts out empty and saves append entries to it in place, after which
+			the size of the section is updated.
+
+			Journal:		Entries, each an uint32 Size followed by a version 2 file
+							of that many bytes
+
+			RemovedSolids:	int32 IDs, only in journal entries
+
+			Solids of an entry replace all earlier solids with the same ID,
+			and removed solids are taken out. The fingerprint of the last entry
+			that has one replaces the one of the file.
+		*/
+		struct FileHeader
+		{
+			/*
+				This must always be the first 4 bytes of every version.
+			*/
+			int32_t FileVersion;
+
+			uint32_t SectionCount;
+			uint32_t SolidCount;
+			uint32_t FaceCount;
+			uint32_t PointCount;
+		};
+
+		enum class SectionType : uint32_t
+		{
+			Solids = 1,
+			Faces,
+			FaceIndex,
+			Points,
+			Journal,
+			RemovedSolids,
+			MapFingerprint,
+		};
+
+		/*
+			Blocks of compressed sections are coded on their own, see VertexCodec.hpp.
+			Only faces and points can be compressed, files with compressed faces have no index.
+		*/
+		enum class SectionEncoding : uint32_t
+		{
+			Raw,
+			Compressed,
+		};
+
+		struct SectionEntry
+		{
+			SectionType Type;
+			SectionEncoding Encoding;
+
+			uint32_t Offset;
+			uint32_t Size;
+		};
+
+		struct SolidRecord
+		{
+			int32_t ID;
+
+			uint32_t FirstFace;
+			uint32_t FaceCount;
+		};
+
+		struct FaceRecord
+		{
+			int32_t ID;
+
+			uint32_t FirstPoint;
+			uint32_t PointCount;
+		};
+
+		struct FaceIndexRecord
+		{
+			int32_t ID;
+			uint32_t Face;
+		};
+
+		struct Solid
+		{
+			int32_t ID;
+
+			uint32_t FirstFace;
+			uint32_t FaceCount;
+		};
+
+		/*
+			"Points" refers directly into the file data.
+		*/
+		struct Face
+		{
+			int32_t ID;
+			int32_t SolidID;
+
+			uint32_t PointCount;
+			const Vector3* Points;
+		};
+
+		/*
+			The map file as it was when the vertex file was saved along with it.
+		*/
+		struct MapFingerprint
+		{
+			uint64_t Size;
+
+			/*
+				In the units of the file system clock.
+			*/
+			uint64_t WriteTime;
+
+			/*
+				FastHash of the whole file.
+			*/
+			uint64_t Hash;
+		};
+
+		bool ComputeMapFingerprint(const std::filesystem::path& path, MapFingerprint& output);
+
+		/*
+			A different size is rejected without reading the map. It is only hashed when
+			the write time is different as well, such as after copying it somewhere else.
+		*/
+		bool MatchesMap(const MapFingerprint& fingerprint, const std::filesystem::path& path);
+
+		enum class LoadStatus
+		{
+			Success,
+			CouldNotOpen,
+			UnsupportedVersion,
+			Truncated,
+			UnsupportedEncoding,
+			StaleMap,
+		};
+
+		const char* LoadStatusToString(LoadStatus status);
+
+		/*
+			Collects the solids and faces of a map as they are saved
+			and lays them out as the newest version. Records are kept in
+			blocks so nothing is copied as they are added.
+		*/
+		class Writer
+		{
+		public:
+			void Clear();
+
+			/*
+				Faces added after this belong to the solid.
+			*/
+			void AddSolid(int32_t id);
+
+			void AddFace(int32_t id, const Vector3* points, uint32_t count);
+
+			/*
+				Adds solid "index" of "other" with all of its faces.
+			*/
+			void CopySolid(const Writer& other, size_t index);
+
+			/*
+				Only written to journal entries.
+			*/
+			void RemoveSolid(int32_t id);
+
+			void SetMapFingerprint(const MapFingerprint& fingerprint);
+
+			/*
+				Nullptr if no fingerprint was set.
+			*/
+			const MapFingerprint* GetMapFingerprint() const
+			{
+				return HasFingerprint ? &Fingerprint : nullptr;
+			}
+
+			size_t GetSolidCount() const
+			{
+				return Solids.GetSize();
+			}
+
+			size_t GetFaceCount() const
+			{
+				return Faces.GetSize();
+			}
+
+			size_t GetPointCount() const
+			{
+				return Points.GetSize();
+			}
+
+			/*
+				Adds all solids of "other" after the ones already here.
+			*/
+			void Append(const Writer& other);
+
+			int32_t GetSolidID(size_t index) const
+			{
+				return Solids[index].ID;
+			}
+
+			/*
+				Same as the hash of the solid once it is read back by MappedVertexFile.
+			*/
+			uint64_t GetSolidHash(size_t index) const;
+
+			/*
+				Journaled files can have entries appended to them later. Raw solids, faces
+				and points are not copied, the output refers to them until this is changed.
+			*/
+			void Serialize(ArenaBuffer& output, SectionEncoding encoding, bool journaled = false) const;
+
+		private:
+			BlockVector<SolidRecord> Solids;
+			BlockVector<FaceRecord> Faces;
+			BlockVector<Vector3> Points;
+
+			std::vector<int32_t> RemovedSolids;
+
+			MapFingerprint Fingerprint = {};
+			bool HasFingerprint = false;
+		};
+
+		/*
+			Solids and faces of a vertex file as views into a memory mapping of it.
+			Compressed faces and points are decoded into memory of its own. Version 2
+			files are decoded on several threads when they are large enough.
+
+			Everything is allocated from one arena that is freed by "Close".
+		*/
+		class MappedVertexFile
+		{
+		public:
+			MappedVertexFile() : MappedVertexFile(OwnArena)
+			{
+
+			}
+
+			/*
+				Allocates from "arena" instead, which then also has to be freed by its owner.
+			*/
+			explicit MappedVertexFile(MonotonicArena& arena);
+
+			MappedVertexFile(const MappedVertexFile&) = delete;
+			MappedVertexFile& operator=(const MappedVertexFile&) = delete;
+
+			/*
+				Opening starts new counters for the arena.
+			*/
+			LoadStatus Open(const std::filesystem::path& path);
+
+			/*
+				Same as Open, but first checks that the file was saved together with the map
+				at "mappath" as it is now. This only reads the section tables, so a stale
+				file is rejected before anything is decoded. Files without a fingerprint
+				are always accepted.
+			*/
+			LoadStatus OpenForMap(const std::filesystem::path& path, const std::filesystem::path& mappath);
+
+			/*
+				Lets other threads call FindFace while the next Open or OpenForMap runs, which
+				has to be started after this. Version 2 files then only wait for the chunk
+				of faces that is asked for, others until they are done. The file is not
+				closed if it fails to load, so the faces that were found stay valid until
+				the owner closes it.
+			*/
+			void BeginConcurrentLoad();
+
+			void Close();
+
+			/*
+				Indexes file data that is already in memory, which has
+				to stay alive for as long as this is used.
+			*/
+			LoadStatus Parse(const void* data, size_t size);
+
+			int32_t GetVersion() const
+			{
+				return FileVersion;
+			}
+
+			const ArenaVector<Solid>& GetSolids() const
+			{
+				return Solids;
+			}
+
+			const ArenaVector<Face>& GetFaces() const
+			{
+				return Faces;
+			}
+
+			const MonotonicArena& GetArena() const
+			{
+				return Arena;
+			}
+
+			size_t GetMappedSize() const
+			{
+				return File.GetSize();
+			}
+
+			/*
+				Nullptr if the file has no fingerprint.
+			*/
+			const MapFingerprint* GetMapFingerprint() const
+			{
+				return HasFingerprint ? &Fingerprint : nullptr;
+			}
+
+			/*
+				Constant time lookup, if an ID is used more than once
+				the first face in the file is returned. During a concurrent
+				load it can also return nullptr because the file failed.
+			*/
+			const Face* FindFace(int32_t id) const;
+
+			/*
+				Hash of the ID, points and point counts of all faces of a solid.
+			*/
+			uint64_t GetSolidHash(size_t index) const;
+
+		private:
+			LoadStatus ParseVersion1(const uint8_t* data, size_t size);
+			/*
+				Journaled files build their index once all entries are applied.
+			*/
+			LoadStatus ParseVersion2(const uint8_t* data, size_t size, bool buildindex);
+			LoadStatus ParseVersion3(const uint8_t* data, size_t size);
+
+			LoadStatus OpenFile(const std::filesystem::path& path, const std::filesystem::path* mappath);
+			LoadStatus MapAndParse(const std::filesystem::path& path, const std::filesystem::path* mappath);
+
+			void EndConcurrentLoad();
+
+			/*
+				Searches the chunks that are decoded so far, and waits for the one the face is in.
+			*/
+			const Face* FindFaceWhileLoading(int32_t id) const;
+
+			/*
+				Puts the solids of all journal entries in place of the ones they replace.
+			*/
+			void ApplyJournal();
+
+			/*
+				Version 2 files provide their sorted index, version 1 files nullptr.
+			*/
+			void BuildFaceIndex(const FaceIndexRecord* sorted);
+
+			MonotonicArena OwnArena;
+			MonotonicArena& Arena;
+
+			MappedFile File;
+
+			int32_t FileVersion = 0;
+
+			ArenaVector<Solid> Solids;
+			ArenaVector<Face> Faces;
+
+			ArenaVector<FaceRecord> DecodedFaces;
+			ArenaVector<Vector3> DecodedPoints;
+
+			ArenaVector<int32_t> RemovedSolids;
+
+			MapFingerprint Fingerprint = {};
+			bool HasFingerprint = false;
+
+			/*
+				Faces of applied entries refer into these, they share the arena.
+			*/
+			std::vector<std::unique_ptr<MappedVertexFile>> JournalEntries;
+
+			/*
+				Index section of version 2 files, nullptr if the file has none.
+			*/
+			const FaceIndexRecord* SortedFaceIndex = nullptr;
+
+			/*
+				Open addressing table of face index + 1, 0 is an empty slot.
+			*/
+			ArenaVector<uint32_t> FaceIndex;
+			uint32_t FaceIndexShift = 32;
+
+			/*
+				Faces of each chunk sorted by ID then face, for files without an index
+				section that are looked up while they are loaded.
+			*/
+			ArenaVector<FaceIndexRecord> ChunkFaceIndex;
+
+			struct LoadProgress
+			{
+				std::mutex Mutex;
+				std::condition_variable Signal;
+
+				/*
+					Set from BeginConcurrentLoad until the file is done or failed.
+				*/
+				std::atomic<bool> Loading{ false };
+
+				/*
+					Set once the chunks are known. Chunk "n" has the faces from
+					ChunkFirstFaces[n] up to ChunkFirstFaces[n + 1].
+				*/
+				bool Planned = false;
+
+				std::vector<uint32_t> ChunkFirstFaces;
+				std::vector<uint8_t> ChunkReady;
+			};
+
+			mutable LoadProgress Progress;
+		};
+	}
+}
@@ -0,0 +1,357 @@
+#include "VertexJournal.hpp"
+
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	struct ScopedFile
+	{
+		ScopedFile(const fs::path& path, const char* mode)
+		{
+			Handle = std::fopen(path.string().c_str(), mode);
+		}
+
+		~ScopedFile()
+		{
+			Close();
+		}
+
+		/*
+			False if buffered data could not be written out.
+		*/
+		bool Close()
+		{
+			auto ret = true;
+
+			if (Handle)
+			{
+				ret = std::fclose(Handle) == 0;
+				Handle = nullptr;
+			}
+
+			return ret;
+		}
+
+		explicit operator bool() const
+		{
+			return Handle != nullptr;
+		}
+
+		template <typename T>
+		bool Read(T& value)
+		{
+			return std::fread(&value, sizeof(T), 1, Handle) == 1;
+		}
+
+		bool Write(const void* data, size_t size)
+		{
+			return std::fwrite(data, size, 1, Handle) == 1;
+		}
+
+		bool Seek(uint32_t offset)
+		{
+			return std::fseek(Handle, static_cast<long>(offset), SEEK_SET) == 0;
+		}
+
+		FILE* Handle = nullptr;
+	};
+}
+
+void HAP::VertexFile::Journal::Reset()
+{
+	Valid = false;
+
+	Path.clear();
+
+	FileSize = 0;
+	JournalOffset = 0;
+	JournalSize = 0;
+	JournalSizeOffset = 0;
+
+	Solids.clear();
+	PendingSolids.clear();
+
+	HasFingerprint = false;
+	HasPendingFingerprint = false;
+}
+
+void HAP::VertexFile::Journal::Assign(const fs::path& path, const MappedVertexFile& file)
+{
+	Reset();
+
+	if (file.GetVersion() != JournaledVersion)
+	{
+		return;
+	}
+
+	const auto& solids = file.GetSolids();
+	Solids.reserve(solids.size());
+
+	for (size_t i = 0; i < solids.size(); i++)
+	{
+		Solids[solids[i].ID] = file.GetSolidHash(i);
+	}
+
+	if (auto fingerprint = file.GetMapFingerprint())
+	{
+		Fingerprint = *fingerprint;
+		HasFingerprint = true;
+	}
+
+	if (!ReadFileState(path))
+	{
+		Reset();
+	}
+}
+
+HAP::VertexFile::JournalUpdate HAP::VertexFile::Journal::Prepare(const fs::path& path, const Writer& vertices, SectionEncoding encoding, ArenaBuffer& output)
+{
+	ChangedCount = 0;
+	RemovedCount = 0;
+
+	auto full = !Valid || path != Path || !IsFileUnchanged();
+
+	auto fingerprint = vertices.GetMapFingerprint();
+
+	HasPendingFingerprint = fingerprint != nullptr;
+
+	if (fingerprint)
+	{
+		PendingFingerprint = *fingerprint;
+	}
+
+	/*
+		Entries cannot take away the fingerprint of an earlier save.
+	*/
+	else if (HasFingerprint)
+	{
+		full = true;
+	}
+
+	auto samefingerprint = HasPendingFingerprint == HasFingerprint &&
+		(!HasFingerprint || std::memcmp(&PendingFingerprint, &Fingerprint, sizeof(Fingerprint)) == 0);
+
+	Writer entry;
+
+	PendingSolids.clear();
+	PendingSolids.reserve(vertices.GetSolidCount());
+
+	for (size_t i = 0; i < vertices.GetSolidCount(); i++)
+	{
+		auto id = vertices.GetSolidID(i);
+		auto hash = vertices.GetSolidHash(i);
+
+		/*
+			Entries replace solids by ID, which only works when they are unique.
+		*/
+		if (!PendingSolids.emplace(id, hash).second)
+		{
+			full = true;
+		}
+
+		if (full)
+		{
+			continue;
+		}
+
+		auto it = Solids.find(id);
+
+		if (it == Solids.end() || it->second != hash)
+		{
+			entry.CopySolid(vertices, i);
+			++ChangedCount;
+		}
+	}
+
+	if (!full)
+	{
+		for (const auto& solid : Solids)
+		{
+			if (PendingSolids.find(solid.first) == PendingSolids.end())
+			{
+				entry.RemoveSolid(solid.first);
+				++RemovedCount;
+			}
+		}
+
+		if (ChangedCount == 0 && RemovedCount == 0 && samefingerprint)
+		{
+			return JournalUpdate::Unchanged;
+		}
+
+		if (fingerprint)
+		{
+			entry.SetMapFingerprint(*fingerprint);
+		}
+
+		ArenaBuffer image;
+		entry.Serialize(image, encoding);
+
+		auto size = static_cast<uint32_t>(image.GetSize());
+
+		if (JournalSize + sizeof(size) + size <= JournalOffset / 2)
+		{
+			/*
+				The image refers to the entry, which is gone after this. Entries are small.
+			*/
+			output.Clear();
+			output.Append(&size, sizeof(size));
+
+			image.ForEachBlock([&](const uint8_t* data, size_t count)
+			{
+				output.Append(data, count);
+				return true;
+			});
+
+			return JournalUpdate::Append;
+		}
+	}
+
+	vertices.Serialize(output, encoding, true);
+	return JournalUpdate::Full;
+}
+
+bool HAP::VertexFile::Journal::Append(const ArenaBuffer& entry)
+{
+	auto ret = false;
+
+	{
+		ScopedFile file(Path, "r+b");
+
+		if (file && file.Seek(JournalOffset + JournalSize))
+		{
+			auto written = entry.ForEachBlock([&](const uint8_t* data, size_t size)
+			{
+				return file.Write(data, size);
+			});
+
+			/*
+				The entry has to be written out before the journal includes it.
+			*/
+			if (written && std::fflush(file.Handle) == 0)
+			{
+				auto size = static_cast<uint32_t>(JournalSize + entry.GetSize());
+				ret = file.Seek(JournalSizeOffset) && file.Write(&size, sizeof(size));
+			}
+		}
+
+		if (!file.Close())
+		{
+			ret = false;
+		}
+	}
+
+	if (!ret || !ReadFileState(Path))
+	{
+		Reset();
+		return false;
+	}
+
+	Solids.swap(PendingSolids);
+	PendingSolids.clear();
+
+	Fingerprint = PendingFingerprint;
+	HasFingerprint = HasPendingFingerprint;
+
+	return true;
+}
+
+bool HAP::VertexFile::Journal::Commit(const fs::path& path)
+{
+	if (!ReadFileState(path))
+	{
+		Reset();
+		return false;
+	}
+
+	Solids.swap(PendingSolids);
+	PendingSolids.clear();
+
+	Fingerprint = PendingFingerprint;
+	HasFingerprint = HasPendingFingerprint;
+
+	return true;
+}
+
+bool HAP::VertexFile::Journal::ReadFileState(const fs::path& path)
+{
+	Valid = false;
+	Path = path;
+
+	std::error_code error;
+
+	FileSize = fs::file_size(path, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	WriteTime = fs::last_write_time(path, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	ScopedFile file(path, "rb");
+
+	FileHeader header;
+
+	if (!file || !file.Read(header) || header.FileVersion != JournaledVersion)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.SectionCount; i++)
+	{
+		SectionEntry entry;
+
+		if (!file.Read(entry))
+		{
+			return false;
+		}
+
+		if (entry.Type != SectionType::Journal)
+		{
+			continue;
+		}
+
+		/*
+			Entries are added at the end of the file.
+		*/
+		if (uint64_t(entry.Offset) + entry.Size != FileSize)
+		{
+			return false;
+		}
+
+		JournalOffset = entry.Offset;
+		JournalSize = entry.Size;
+		JournalSizeOffset = static_cast<uint32_t>(sizeof(header) + i * sizeof(entry) + offsetof(SectionEntry, Size));
+
+		Valid = true;
+		return true;
+	}
+
+	return false;
+}
+
+bool HAP::VertexFile::Journal::IsFileUnchanged() const
+{
+	std::error_code error;
+
+	auto size = fs::file_size(Path, error);
+
+	if (error || size != FileSize)
+	{
+		return false;
+	}
+
+	auto time = fs::last_write_time(Path, error);
+
+	return !error && time == WriteTime;
+}
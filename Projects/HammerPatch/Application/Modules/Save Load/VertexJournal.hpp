@@ -0,0 +1,121 @@
+#pragma once
+#include "VertexFile.hpp"
+
+#include <filesystem>
+#include <unordered_map>
+
+namespace HAP
+{
+	namespace VertexFile
+	{
+		enum class JournalUpdate
+		{
+			/*
+				The file already has these solids and map fingerprint, nothing has to be written.
+			*/
+			Unchanged,
+
+			/*
+				The output is an entry for Journal::Append.
+			*/
+			Append,
+
+			/*
+				The output is a whole journaled file, Journal::Commit follows once it is written.
+			*/
+			Full,
+		};
+
+		/*
+			Keeps the hash of every solid in a journaled vertex file, so a save only has to
+			append the solids that changed. The whole file is written again when it was
+			changed by anything else, or when the journal grows past half the size of the
+			rest of the file.
+		*/
+		class Journal
+		{
+		public:
+			/*
+				The next save writes the whole file.
+			*/
+			void Reset();
+
+			/*
+				Takes over the solids of a file that was just loaded. Files without
+				a journal are written in full by the next save.
+			*/
+			void Assign(const std::filesystem::path& path, const MappedVertexFile& file);
+
+			JournalUpdate Prepare(const std::filesystem::path& path, const Writer& vertices, SectionEncoding encoding, ArenaBuffer& output);
+
+			/*
+				Appends the entry from Prepare to the file in place. The size of the journal
+				is only updated after the entry is written, so a failed append leaves the
+				file as it was. The next save then writes all of it.
+			*/
+			bool Append(const ArenaBuffer& entry);
+
+			bool Commit(const std::filesystem::path& path);
+
+			/*
+				Solids in the last entry from Prepare.
+			*/
+			size_t GetChangedCount() const
+			{
+				return ChangedCount;
+			}
+
+			size_t GetRemovedCount() const
+			{
+				return RemovedCount;
+			}
+
+		private:
+			/*
+				Where the journal is and when the file was written, false
+				if entries cannot be appended to it.
+			*/
+			bool ReadFileState(const std::filesystem::path& path);
+
+			bool IsFileUnchanged() const;
+
+			bool Valid = false;
+
+			std::filesystem::path Path;
+
+			uint64_t FileSize = 0;
+			std::filesystem::file_time_type WriteTime;
+
+			/*
+				Everything before the journal.
+			*/
+			uint32_t JournalOffset = 0;
+			uint32_t JournalSize = 0;
+
+			/*
+				Where the size of the journal is in the section table.
+			*/
+			uint32_t JournalSizeOffset = 0;
+
+			std::unordered_map<int32_t, uint64_t> Solids;
+
+			/*
+				Solids of the last save, until it is written.
+			*/
+			std::unordered_map<int32_t, uint64_t> PendingSolids;
+
+			/*
+				An entry with only a new fingerprint is still appended,
+				the map changes with every save.
+			*/
+			MapFingerprint Fingerprint = {};
+			bool HasFingerprint = false;
+
+			MapFingerprint PendingFingerprint = {};
+			bool HasPendingFingerprint = false;
+
+			size_t ChangedCount = 0;
+			size_t RemovedCount = 0;
+		};
+	}
+}
@@ -0,0 +1,471 @@
+#include "VertexText.hpp"
+#include "Application/Text/FloatText.hpp"
+#include "Application/Threading/RunChunks.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	enum
+	{
+		/*
+			About 100 KB of text each.
+		*/
+		SolidsPerChunk = 256,
+
+		ChunkBlockSize = 1 << 18,
+
+		/*
+			Text is split into parts of about this size for parsing.
+		*/
+		ParseChunkSize = 1 << 20,
+	};
+
+	inline char* WriteString(char* dest, const char* text, size_t length)
+	{
+		std::memcpy(dest, text, length);
+		return dest + length;
+	}
+
+	template <size_t Size>
+	inline char* WriteString(char* dest, const char(&text)[Size])
+	{
+		return WriteString(dest, text, Size - 1);
+	}
+
+	inline char* WriteInteger(char* dest, int32_t value)
+	{
+		auto absolute = static_cast<uint32_t>(value);
+
+		if (value < 0)
+		{
+			*dest++ = '-';
+			absolute = 0u - absolute;
+		}
+
+		char digits[10];
+		size_t count = 0;
+
+		do
+		{
+			digits[count++] = static_cast<char>('0' + absolute % 10);
+			absolute /= 10;
+		}
+		while (absolute != 0);
+
+		while (count > 0)
+		{
+			*dest++ = digits[--count];
+		}
+
+		return dest;
+	}
+
+	/*
+		"prefix" followed by the ID and a line break.
+	*/
+	template <size_t Size>
+	void AppendIDLine(HAP::ArenaBuffer& output, const char(&prefix)[Size], int32_t id)
+	{
+		auto start = reinterpret_cast<char*>(output.Reserve(Size + 16));
+
+		auto dest = WriteString(start, prefix);
+		dest = WriteInteger(dest, id);
+		*dest++ = '\n';
+
+		output.Commit(dest - start);
+	}
+
+	inline bool IsBlank(char value)
+	{
+		return value == ' ' || value == '\t' || value == '\r';
+	}
+
+	inline const char* SkipBlanks(const char* first, const char* last)
+	{
+		while (first != last && IsBlank(*first))
+		{
+			++first;
+		}
+
+		return first;
+	}
+
+	template <size_t Size>
+	inline bool StartsWith(const char* first, const char* last, const char(&text)[Size])
+	{
+		auto length = Size - 1;
+		return static_cast<size_t>(last - first) >= length && std::memcmp(first, text, length) == 0;
+	}
+
+	const char* ParseInteger(const char* first, const char* last, int32_t& value)
+	{
+		bool negative = false;
+
+		if (first != last && *first == '-')
+		{
+			negative = true;
+			++first;
+		}
+
+		auto start = first;
+		int64_t result = 0;
+
+		while (first != last && *first >= '0' && *first <= '9')
+		{
+			result = result * 10 + (*first - '0');
+
+			if (result > 2147483648LL)
+			{
+				return nullptr;
+			}
+
+			++first;
+		}
+
+		if (first == start)
+		{
+			return nullptr;
+		}
+
+		if (negative)
+		{
+			result = -result;
+		}
+
+		if (result > INT32_MAX)
+		{
+			return nullptr;
+		}
+
+		value = static_cast<int32_t>(result);
+		return first;
+	}
+
+	/*
+		Where a solid line starts at or after "position", or "last" if there are no more.
+	*/
+	const char* FindSolidLine(const char* position, const char* first, const char* last)
+	{
+		if (position != first)
+		{
+			position = static_cast<const char*>(std::memchr(position, '\n', last - position));
+
+			if (!position)
+			{
+				return last;
+			}
+
+			++position;
+		}
+
+		while (position != last)
+		{
+			auto start = SkipBlanks(position, last);
+
+			if (StartsWith(start, last, "solid"))
+			{
+				return position;
+			}
+
+			position = static_cast<const char*>(std::memchr(start, '\n', last - start));
+
+			if (!position)
+			{
+				return last;
+			}
+
+			++position;
+		}
+
+		return last;
+	}
+
+	struct ParseChunk
+	{
+		HAP::VertexFile::Writer Output;
+
+		HAP::VertexFile::Text::ParseStatus Status = HAP::VertexFile::Text::ParseStatus::Success;
+		const char* ErrorPosition = nullptr;
+	};
+
+	void ParseLines(const char* first, const char* last, ParseChunk& chunk)
+	{
+		using HAP::VertexFile::Text::ParseStatus;
+
+		std::vector<HAP::Vector3> points;
+
+		bool insolid = false;
+		bool inface = false;
+		int32_t faceid = 0;
+
+		auto endface = [&]()
+		{
+			if (inface)
+			{
+				chunk.Output.AddFace(faceid, points.data(), static_cast<uint32_t>(points.size()));
+				points.clear();
+			}
+		};
+
+		auto fail = [&](ParseStatus status, const char* position)
+		{
+			chunk.Status = status;
+			chunk.ErrorPosition = position;
+		};
+
+		auto position = first;
+
+		while (position != last)
+		{
+			auto line = position;
+			auto cur = SkipBlanks(position, last);
+
+			if (cur == last || *cur == '\n')
+			{
+				position = cur == last ? last : cur + 1;
+				continue;
+			}
+
+			if (StartsWith(cur, last, "solid id:"))
+			{
+				int32_t id;
+				cur = ParseInteger(SkipBlanks(cur + 9, last), last, id);
+
+				if (!cur)
+				{
+					fail(ParseStatus::InvalidLine, line);
+					return;
+				}
+
+				endface();
+				chunk.Output.AddSolid(id);
+
+				insolid = true;
+				inface = false;
+			}
+
+			else if (StartsWith(cur, last, "face id:"))
+			{
+				if (!insolid)
+				{
+					fail(ParseStatus::FaceOutsideSolid, line);
+					return;
+				}
+
+				int32_t id;
+				cur = ParseInteger(SkipBlanks(cur + 8, last), last, id);
+
+				if (!cur)
+				{
+					fail(ParseStatus::InvalidLine, line);
+					return;
+				}
+
+				endface();
+
+				faceid = id;
+				inface = true;
+			}
+
+			else if (*cur == '[')
+			{
+				if (!inface)
+				{
+					fail(ParseStatus::PointOutsideFace, line);
+					return;
+				}
+
+				HAP::Vector3 point;
+				float* values[] = { &point.X, &point.Y, &point.Z };
+
+				++cur;
+
+				for (auto value : values)
+				{
+					cur = SkipBlanks(cur, last);
+					cur = HAP::FloatText::Parse(cur, last, *value);
+
+					if (!cur)
+					{
+						fail(ParseStatus::InvalidLine, line);
+						return;
+					}
+				}
+
+				cur = SkipBlanks(cur, last);
+
+				if (cur == last || *cur != ']')
+				{
+					fail(ParseStatus::InvalidLine, line);
+					return;
+				}
+
+				++cur;
+				points.emplace_back(point);
+			}
+
+			else
+			{
+				fail(ParseStatus::InvalidLine, line);
+				return;
+			}
+
+			cur = SkipBlanks(cur, last);
+
+			if (cur != last)
+			{
+				if (*cur != '\n')
+				{
+					fail(ParseStatus::InvalidLine, line);
+					return;
+				}
+
+				++cur;
+			}
+
+			position = cur;
+		}
+
+		endface();
+	}
+}
+
+void HAP::VertexFile::Text::AppendSolid(ArenaBuffer& output, int32_t id)
+{
+	AppendIDLine(output, "solid id: ", id);
+}
+
+void HAP::VertexFile::Text::AppendFace(ArenaBuffer& output, int32_t id)
+{
+	AppendIDLine(output, "\tface id: ", id);
+}
+
+void HAP::VertexFile::Text::AppendPoint(ArenaBuffer& output, const Vector3& point)
+{
+	enum
+	{
+		LineSize = 3 * FloatText::MaxLength + 8
+	};
+
+	auto start = reinterpret_cast<char*>(output.Reserve(LineSize));
+
+	auto dest = WriteString(start, "\t\t[");
+
+	dest += FloatText::Format(point.X, dest);
+	*dest++ = ' ';
+
+	dest += FloatText::Format(point.Y, dest);
+	*dest++ = ' ';
+
+	dest += FloatText::Format(point.Z, dest);
+
+	dest = WriteString(dest, "]\n");
+
+	output.Commit(dest - start);
+}
+
+void HAP::VertexFile::Text::Render(const MappedVertexFile& file, ArenaBuffer& output)
+{
+	const auto& solids = file.GetSolids();
+	const auto& faces = file.GetFaces();
+
+	auto chunkcount = (solids.size() + SolidsPerChunk - 1) / SolidsPerChunk;
+
+	std::vector<ArenaBuffer> chunks;
+	chunks.reserve(chunkcount);
+
+	for (size_t i = 0; i < chunkcount; i++)
+	{
+		chunks.emplace_back(ChunkBlockSize);
+	}
+
+	HAP::RunChunks(chunkcount, HAP::GetWorkerCount(), [&](size_t index)
+	{
+		auto& chunk = chunks[index];
+
+		auto first = index * SolidsPerChunk;
+		auto last = std::min(first + SolidsPerChunk, solids.size());
+
+		for (auto i = first; i < last; i++)
+		{
+			const auto& solid = solids[i];
+
+			AppendSolid(chunk, solid.ID);
+
+			for (uint32_t j = 0; j < solid.FaceCount; j++)
+			{
+				const auto& face = faces[solid.FirstFace + j];
+
+				AppendFace(chunk, face.ID);
+
+				for (uint32_t k = 0; k < face.PointCount; k++)
+				{
+					AppendPoint(chunk, face.Points[k]);
+				}
+			}
+		}
+	});
+
+	output.Clear();
+
+	for (auto& chunk : chunks)
+	{
+		output.Splice(chunk);
+	}
+}
+
+const char* HAP::VertexFile::Text::ParseStatusToString(ParseStatus status)
+{
+	static const char* table[] =
+	{
+		"Success",
+		"Face is not part of a solid",
+		"Point is not part of a face",
+		"Line could not be read",
+	};
+
+	return table[static_cast<size_t>(status)];
+}
+
+HAP::VertexFile::Text::ParseStatus HAP::VertexFile::Text::Parse(const char* data, size_t size, Writer& output, size_t& errorline)
+{
+	auto last = data + size;
+
+	/*
+		Every part but the first starts at a solid line, so parts can be read
+		without knowing what came before them.
+	*/
+	std::vector<const char*> bounds;
+	bounds.emplace_back(data);
+
+	while (bounds.back() != last)
+	{
+		auto position = bounds.back() + std::min<size_t>(ParseChunkSize, last - bounds.back());
+		bounds.emplace_back(FindSolidLine(position, data, last));
+	}
+
+	std::vector<ParseChunk> chunks(bounds.size() - 1);
+
+	HAP::RunChunks(chunks.size(), HAP::GetWorkerCount(), [&](size_t index)
+	{
+		ParseLines(bounds[index], bounds[index + 1], chunks[index]);
+	});
+
+	output.Clear();
+
+	for (auto& chunk : chunks)
+	{
+		if (chunk.Status != ParseStatus::Success)
+		{
+			errorline = 1 + std::count(data, chunk.ErrorPosition, '\n');
+			return chunk.Status;
+		}
+
+		output.Append(chunk.Output);
+	}
+
+	return ParseStatus::Success;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "VertexFile.hpp"
+
+/*
+	The human readable .hpvertstext form of vertex files:
+
+	solid id: 1
+		face id: 2
+			[0 0 64]
+			[128 0 64]
+			...
+
+	Points are written with the fewest digits that read back as the same float.
+*/
+namespace HAP
+{
+	namespace VertexFile
+	{
+		namespace Text
+		{
+			void AppendSolid(ArenaBuffer& output, int32_t id);
+			void AppendFace(ArenaBuffer& output, int32_t id);
+			void AppendPoint(ArenaBuffer& output, const Vector3& point);
+
+			/*
+				The text of a whole file. Solids are formatted on several threads
+				and put together in the order of the file.
+			*/
+			void Render(const MappedVertexFile& file, ArenaBuffer& output);
+
+			enum class ParseStatus
+			{
+				Success,
+				FaceOutsideSolid,
+				PointOutsideFace,
+				InvalidLine,
+			};
+
+			const char* ParseStatusToString(ParseStatus status);
+
+			/*
+				Reads text back into solids. Indentation, blank lines and "\r\n" line breaks
+				are accepted. Parts of the text that start with a solid are read on several threads.
+				On failure "errorline" is the first line that could not be read, counted from 1.
+			*/
+			ParseStatus Parse(const char* data, size_t size, Writer& output, size_t& errorline);
+		}
+	}
+}
@@ -0,0 +1,390 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+/*
+	Minimal PE header reader. Only depends on the standard library so it works on
+	both a loaded module and a DLL file read from disk, on any platform.
+*/
+namespace HAP
+{
+	namespace PE
+	{
+		enum : uint32_t
+		{
+			SectionContainsCode = 0x00000020,
+			SectionMemoryExecute = 0x20000000,
+		};
+
+		/*
+			A loaded module has its sections at their virtual addresses,
+			a file on disk has them at their raw offsets.
+		*/
+		enum class ImageLayout
+		{
+			Mapped,
+			File,
+		};
+
+		struct Section
+		{
+			char Name[9];
+
+			uint32_t VirtualAddress;
+			uint32_t VirtualSize;
+			uint32_t RawOffset;
+			uint32_t RawSize;
+			uint32_t Characteristics;
+
+			bool IsExecutable() const
+			{
+				return (Characteristics & (SectionContainsCode | SectionMemoryExecute)) != 0;
+			}
+		};
+
+		struct ImageHeaders
+		{
+			uint16_t Machine;
+			uint32_t TimeDateStamp;
+			uint32_t SizeOfImage;
+			uint64_t ImageBase;
+
+			uint32_t RelocationsRVA;
+			uint32_t RelocationsSize;
+
+			std::vector<Section> Sections;
+		};
+
+		namespace Detail
+		{
+			template <typename T>
+			inline bool Read(const uint8_t* data, size_t size, size_t offset, T& value)
+			{
+				if (offset > size || size - offset < sizeof(T))
+				{
+					return false;
+				}
+
+				std::memcpy(&value, data + offset, sizeof(T));
+				return true;
+			}
+		}
+
+		inline bool ReadHeaders(const void* image, size_t size, ImageHeaders& headers)
+		{
+			auto data = static_cast<const uint8_t*>(image);
+
+			uint16_t dosmagic;
+
+			if (!Detail::Read(data, size, 0, dosmagic) || dosmagic != 0x5A4D)
+			{
+				return false;
+			}
+
+			uint32_t ntoffset;
+
+			if (!Detail::Read(data, size, 0x3C, ntoffset))
+			{
+				return false;
+			}
+
+			uint32_t ntmagic;
+
+			if (!Detail::Read(data, size, ntoffset, ntmagic) || ntmagic != 0x00004550)
+			{
+				return false;
+			}
+
+			auto fileheader = size_t(ntoffset) + 4;
+			auto optionalheader = fileheader + 20;
+
+			uint16_t sectioncount = 0;
+			uint16_t optionalsize = 0;
+
+			bool res = true;
+			res &= Detail::Read(data, size, fileheader + 0, headers.Machine);
+			res &= Detail::Read(data, size, fileheader + 2, sectioncount);
+			res &= Detail::Read(data, size, fileheader + 4, headers.TimeDateStamp);
+			res &= Detail::Read(data, size, fileheader + 16, optionalsize);
+
+			/*
+				Same offset in both PE32 and PE32+ optional headers.
+			*/
+			res &= Detail::Read(data, size, optionalheader + 56, headers.SizeOfImage);
+
+			uint16_t optionalmagic;
+			res &= Detail::Read(data, size, optionalheader, optionalmagic);
+
+			if (!res)
+			{
+				return false;
+			}
+
+			size_t directories;
+			uint32_t directorycount = 0;
+
+			if (optionalmagic == 0x20B)
+			{
+				res &= Detail::Read(data, size, optionalheader + 24, headers.ImageBase);
+				res &= Detail::Read(data, size, optionalheader + 108, directorycount);
+				directories = optionalheader + 112;
+			}
+
+			else
+			{
+				uint32_t imagebase = 0;
+				res &= Detail::Read(data, size, optionalheader + 28, imagebase);
+				res &= Detail::Read(data, size, optionalheader + 92, directorycount);
+
+				if (res)
+				{
+					headers.ImageBase = imagebase;
+				}
+
+				directories = optionalheader + 96;
+			}
+
+			headers.RelocationsRVA = 0;
+			headers.RelocationsSize = 0;
+
+			/*
+				Base relocation table is the sixth data directory.
+			*/
+			if (res && directorycount > 5)
+			{
+				res &= Detail::Read(data, size, directories + 5 * 8, headers.RelocationsRVA);
+				res &= Detail::Read(data, size, directories + 5 * 8 + 4, headers.RelocationsSize);
+			}
+
+			if (!res)
+			{
+				return false;
+			}
+
+			auto sectiontable = optionalheader + optionalsize;
+
+			headers.Sections.clear();
+			headers.Sections.reserve(sectioncount);
+
+			for (size_t i = 0; i < sectioncount; i++)
+			{
+				auto offset = sectiontable + i * 40;
+
+				Section section = {};
+
+				res &= Detail::Read(data, size, offset, reinterpret_cast<char(&)[8]>(section.Name));
+				res &= Detail::Read(data, size, offset + 8, section.VirtualSize);
+				res &= Detail::Read(data, size, offset + 12, section.VirtualAddress);
+				res &= Detail::Read(data, size, offset + 16, section.RawSize);
+				res &= Detail::Read(data, size, offset + 20, section.RawOffset);
+				res &= Detail::Read(data, size, offset + 36, section.Characteristics);
+
+				if (!res)
+				{
+					return false;
+				}
+
+				section.Name[8] = 0;
+				headers.Sections.emplace_back(section);
+			}
+
+			return true;
+		}
+
+		/*
+			Offset and length of a section inside an image of the given layout,
+			clamped to the image size. Returns false if nothing of it is present.
+		*/
+		inline bool GetSectionRange(const Section& section, ImageLayout layout, size_t imagesize, size_t& offset, size_t& length)
+		{
+			if (layout == ImageLayout::Mapped)
+			{
+				offset = section.VirtualAddress;
+				length = section.VirtualSize ? section.VirtualSize : section.RawSize;
+			}
+
+			else
+			{
+				offset = section.RawOffset;
+				length = section.RawSize;
+
+				/*
+					Raw data is padded to the file alignment.
+				*/
+				if (section.VirtualSize && section.VirtualSize < length)
+				{
+					length = section.VirtualSize;
+				}
+			}
+
+			if (offset >= imagesize || length == 0)
+			{
+				return false;
+			}
+
+			if (length > imagesize - offset)
+			{
+				length = imagesize - offset;
+			}
+
+			return true;
+		}
+
+		/*
+			Converts an offset into the file on disk to the address it has
+			relative to the module base once loaded.
+		*/
+		inline bool FileOffsetToRVA(const ImageHeaders& headers, size_t offset, uint32_t& rva)
+		{
+			for (const auto& section : headers.Sections)
+			{
+				if (offset >= section.RawOffset && offset - section.RawOffset < section.RawSize)
+				{
+					rva = static_cast<uint32_t>(offset - section.RawOffset + section.VirtualAddress);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		inline bool RVAToFileOffset(const ImageHeaders& headers, uint32_t rva, size_t& offset)
+		{
+			for (const auto& section : headers.Sections)
+			{
+				if (rva >= section.VirtualAddress && rva - section.VirtualAddress < section.RawSize)
+				{
+					offset = size_t(rva) - section.VirtualAddress + section.RawOffset;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/*
+			An address in the image that the loader rewrites when the module
+			does not get its preferred base.
+		*/
+		struct Relocation
+		{
+			uint32_t RVA;
+			uint32_t Size;
+		};
+
+		inline std::vector<Relocation> ReadRelocations(const void* image, size_t size, const ImageHeaders& headers, ImageLayout layout)
+		{
+			std::vector<Relocation> ret;
+
+			if (headers.RelocationsRVA == 0 || headers.RelocationsSize == 0)
+			{
+				return ret;
+			}
+
+			size_t offset = headers.RelocationsRVA;
+
+			if (layout == ImageLayout::File)
+			{
+				if (!RVAToFileOffset(headers, headers.RelocationsRVA, offset))
+				{
+					return ret;
+				}
+			}
+
+			auto data = static_cast<const uint8_t*>(image);
+			auto end = offset + headers.RelocationsSize;
+
+			while (offset + 8 <= end)
+			{
+				uint32_t page;
+				uint32_t blocksize;
+
+				if (!Detail::Read(data, size, offset, page) || !Detail::Read(data, size, offset + 4, blocksize) || blocksize < 8)
+				{
+					break;
+				}
+
+				for (size_t i = 8; i + 2 <= blocksize; i += 2)
+				{
+					uint16_t entry;
+
+					if (!Detail::Read(data, size, offset + i, entry))
+					{
+						return ret;
+					}
+
+					auto type = entry >> 12;
+					auto rva = page + (entry & 0xFFF);
+
+					/*
+						HIGHLOW for 32 bit images, DIR64 for 64 bit ones.
+						Anything else is padding or not used on x86.
+					*/
+					if (type == 3)
+					{
+						ret.push_back({ rva, 4 });
+					}
+
+					else if (type == 10)
+					{
+						ret.push_back({ rva, 8 });
+					}
+				}
+
+				offset += blocksize;
+			}
+
+			return ret;
+		}
+
+		struct ImageRange
+		{
+			size_t Offset;
+			size_t Length;
+		};
+
+		/*
+			Executable sections of the image in address order, or only the section
+			called "name" if one is given.
+		*/
+		inline std::vector<ImageRange> GetCodeRanges(const ImageHeaders& headers, ImageLayout layout, size_t imagesize, const char* name = nullptr)
+		{
+			std::vector<ImageRange> ret;
+
+			for (const auto& section : headers.Sections)
+			{
+				if (name)
+				{
+					if (std::strcmp(section.Name, name) != 0)
+					{
+						continue;
+					}
+				}
+
+				else if (!section.IsExecutable())
+				{
+					continue;
+				}
+
+				ImageRange range;
+
+				if (GetSectionRange(section, layout, imagesize, range.Offset, range.Length))
+				{
+					ret.emplace_back(range);
+				}
+			}
+
+			for (size_t i = 1; i < ret.size(); i++)
+			{
+				for (size_t j = i; j > 0 && ret[j].Offset < ret[j - 1].Offset; j--)
+				{
+					std::swap(ret[j], ret[j - 1]);
+				}
+			}
+
+			return ret;
+		}
+	}
+}
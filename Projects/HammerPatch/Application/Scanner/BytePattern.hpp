@@ -0,0 +1,402 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace HAP
+{
+	/*
+		Named run of wildcard bytes whose value is read from the memory the pattern
+		matched, such as the displacement of a structure member.
+	*/
+	struct PatternCapture
+	{
+		enum
+		{
+			MaxNameLength = 23
+		};
+
+		char Name[MaxNameLength + 1] = {};
+
+		size_t Offset = 0;
+		size_t Size = 0;
+	};
+
+	/*
+		Byte signature as value and mask arrays, a mask of 0 is a wildcard. The arrays
+		are padded with wildcards to "PaddedLength", a multiple of 16, so they can be
+		read in whole vector blocks.
+	*/
+	struct BytePattern
+	{
+		const uint8_t* Values;
+		const uint8_t* Masks;
+
+		size_t Length;
+		size_t PaddedLength;
+
+		const PatternCapture* Captures;
+		size_t CaptureCount;
+
+		bool IsKnown(size_t index) const
+		{
+			return Masks[index] != 0;
+		}
+
+		const PatternCapture* FindCapture(const char* name) const
+		{
+			for (size_t i = 0; i < CaptureCount; i++)
+			{
+				if (std::strcmp(Captures[i].Name, name) == 0)
+				{
+					return &Captures[i];
+				}
+			}
+
+			return nullptr;
+		}
+	};
+
+	/*
+		Sign extended little endian value of a capture slot, "match" is where
+		the pattern was found.
+	*/
+	inline int32_t ReadCapture(const void* match, const PatternCapture& capture)
+	{
+		auto data = static_cast<const uint8_t*>(match) + capture.Offset;
+
+		switch (capture.Size)
+		{
+			case 1:
+			{
+				return static_cast<int8_t>(data[0]);
+			}
+
+			case 2:
+			{
+				return static_cast<int16_t>(data[0] | (data[1] << 8));
+			}
+		}
+
+		return static_cast<int32_t>(uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24));
+	}
+
+	namespace PatternDetail
+	{
+		enum : size_t
+		{
+			InvalidPattern = size_t(-1)
+		};
+
+		constexpr size_t GetPaddedSize(size_t length)
+		{
+			return (length + 15) & ~size_t(15);
+		}
+
+		constexpr bool IsSpace(char value)
+		{
+			return value == ' ' || value == '\t' || value == '\r' || value == '\n';
+		}
+
+		constexpr bool Compare(const char* first, const char* second)
+		{
+			while (*first && *first == *second)
+			{
+				++first;
+				++second;
+			}
+
+			return *first == *second;
+		}
+
+		constexpr bool IsNameCharacter(char value)
+		{
+			return (value >= 'a' && value <= 'z') || (value >= 'A' && value <= 'Z') || (value >= '0' && value <= '9') || value == '_';
+		}
+
+		constexpr int GetHexValue(char value)
+		{
+			if (value >= '0' && value <= '9')
+			{
+				return value - '0';
+			}
+
+			if (value >= 'a' && value <= 'f')
+			{
+				return value - 'a' + 10;
+			}
+
+			if (value >= 'A' && value <= 'F')
+			{
+				return value - 'A' + 10;
+			}
+
+			return -1;
+		}
+
+		/*
+			Reads a capture token such as "{Name:4}" which stands for that many wildcards.
+			Returns the position after the token or nullptr if it is malformed.
+		*/
+		constexpr const char* ParseCapture(const char* input, PatternCapture& capture)
+		{
+			++input;
+
+			size_t length = 0;
+
+			while (IsNameCharacter(*input))
+			{
+				if (length == PatternCapture::MaxNameLength)
+				{
+					return nullptr;
+				}
+
+				capture.Name[length++] = *input++;
+			}
+
+			capture.Name[length] = 0;
+
+			if (length == 0 || input[0] != ':' || input[1] == 0 || input[2] != '}')
+			{
+				return nullptr;
+			}
+
+			switch (input[1])
+			{
+				case '1':
+				{
+					capture.Size = 1;
+					break;
+				}
+
+				case '2':
+				{
+					capture.Size = 2;
+					break;
+				}
+
+				case '4':
+				{
+					capture.Size = 4;
+					break;
+				}
+
+				default:
+				{
+					return nullptr;
+				}
+			}
+
+			return input + 3;
+		}
+
+		/*
+			Reads whitespace separated tokens of two hex digits, "??" / "?" for wildcards
+			or "{Name:Size}" for a capture of 1, 2 or 4 wildcards. Returns the number of bytes
+			or "InvalidPattern" if the text is malformed or does not fit in "capacity" bytes
+			and "capturecapacity" captures.
+		*/
+		constexpr size_t Parse(const char* input, uint8_t* values, uint8_t* masks, size_t capacity, PatternCapture* captures, size_t capturecapacity, size_t& capturecount)
+		{
+			size_t count = 0;
+			capturecount = 0;
+
+			while (*input)
+			{
+				if (IsSpace(*input))
+				{
+					++input;
+					continue;
+				}
+
+				if (count == capacity)
+				{
+					return InvalidPattern;
+				}
+
+				if (*input == '{')
+				{
+					if (capturecount == capturecapacity)
+					{
+						return InvalidPattern;
+					}
+
+					auto& capture = captures[capturecount];
+					input = ParseCapture(input, capture);
+
+					if (!input || capture.Size > capacity - count)
+					{
+						return InvalidPattern;
+					}
+
+					for (size_t i = 0; i < capturecount; i++)
+					{
+						if (Compare(captures[i].Name, capture.Name))
+						{
+							return InvalidPattern;
+						}
+					}
+
+					capture.Offset = count;
+
+					for (size_t i = 0; i < capture.Size; i++)
+					{
+						values[count] = 0;
+						masks[count] = 0;
+						++count;
+					}
+
+					++capturecount;
+
+					if (*input && !IsSpace(*input))
+					{
+						return InvalidPattern;
+					}
+
+					continue;
+				}
+
+				if (*input == '?')
+				{
+					++input;
+
+					if (*input == '?')
+					{
+						++input;
+					}
+
+					values[count] = 0;
+					masks[count] = 0;
+				}
+
+				else
+				{
+					auto high = GetHexValue(input[0]);
+
+					if (high < 0)
+					{
+						return InvalidPattern;
+					}
+
+					auto low = GetHexValue(input[1]);
+
+					if (low < 0)
+					{
+						return InvalidPattern;
+					}
+
+					values[count] = static_cast<uint8_t>(high * 16 + low);
+					masks[count] = 0xFF;
+
+					input += 2;
+				}
+
+				if (*input && !IsSpace(*input))
+				{
+					return InvalidPattern;
+				}
+
+				++count;
+			}
+
+			return count;
+		}
+	}
+
+	template <size_t Capacity>
+	struct StaticBytePattern
+	{
+		enum
+		{
+			MaxCaptures = 4
+		};
+
+		uint8_t Values[Capacity] = {};
+		uint8_t Masks[Capacity] = {};
+
+		size_t Length = 0;
+
+		PatternCapture Captures[MaxCaptures] = {};
+		size_t CaptureCount = 0;
+
+		constexpr BytePattern Get() const
+		{
+			return { Values, Masks, Length, PatternDetail::GetPaddedSize(Length), Captures, CaptureCount };
+		}
+	};
+
+	/*
+		Parses a pattern such as "55 8B EC ?? ?? 8B {Offset:4}" at compile time when assigned to a
+		constexpr variable. Malformed patterns fail to compile.
+	*/
+	template <size_t Size>
+	constexpr auto CompilePattern(const char(&input)[Size])
+	{
+		/*
+			Captures can be shorter than the bytes they stand for,
+			anything else takes at least two characters per byte.
+		*/
+		StaticBytePattern<PatternDetail::GetPaddedSize(Size)> ret;
+
+		auto length = PatternDetail::Parse(input, ret.Values, ret.Masks, Size, ret.Captures, ret.MaxCaptures, ret.CaptureCount);
+
+		if (length == PatternDetail::InvalidPattern || length == 0)
+		{
+			throw "Malformed byte pattern";
+		}
+
+		ret.Length = length;
+		return ret;
+	}
+
+	/*
+		Owning storage for patterns parsed at runtime.
+	*/
+	struct BytePatternBuffer
+	{
+		std::vector<uint8_t> Values;
+		std::vector<uint8_t> Masks;
+
+		size_t Length = 0;
+
+		std::vector<PatternCapture> Captures;
+
+		BytePattern Get() const;
+	};
+
+	BytePatternBuffer GetPatternFromString(const char* input);
+
+	struct NamedPattern
+	{
+		const char* Name;
+
+		/*
+			Source branch the pattern was made for, such as "2013" or "CSGO".
+		*/
+		const char* Game;
+
+		BytePattern Pattern;
+	};
+
+	/*
+		Search method used for single pattern lookups. All of them give the same results.
+	*/
+	enum class PatternScanEngine
+	{
+		/*
+			SSE2 or AVX2 candidate filtering on the first and last known byte.
+		*/
+		Vector,
+
+		/*
+			Skip table search on the longest run of known bytes.
+		*/
+		Horspool,
+
+		/*
+			Byte by byte reference search.
+		*/
+		Scalar,
+	};
+}
@@ -0,0 +1,960 @@
+#include "PatternScanner.hpp"
+#include "Application/Threading/RunChunks.hpp"
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define HAP_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define HAP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#include <immintrin.h>
+
+/*
+	This file is shared with the tools and must not depend on Windows or the precompiled header.
+*/
+
+namespace
+{
+	namespace Memory
+	{
+		inline uint32_t CountTrailingZeros(uint32_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, value);
+
+			return index;
+#else
+			return __builtin_ctz(value);
+#endif
+		}
+
+		/*
+			Not accessing the STL iterators in debug mode makes this run >10x faster, less sitting around waiting for nothing.
+		*/
+		inline bool DataCompare(const uint8_t* data, const HAP::BytePattern& pattern)
+		{
+			auto values = pattern.Values;
+			auto masks = pattern.Masks;
+
+			for (size_t i = 0; i < pattern.Length; i++)
+			{
+				if ((data[i] ^ values[i]) & masks[i])
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/*
+			Reference implementation, every other search path has to produce the same result as this.
+		*/
+		void* FindPatternScalar(void* start, size_t searchlength, const HAP::BytePattern& pattern)
+		{
+			auto length = pattern.Length;
+
+			if (length == 0 || length > searchlength)
+			{
+				return nullptr;
+			}
+			
+			for (size_t i = 0; i <= searchlength - length; ++i)
+			{
+				auto addr = (const uint8_t*)(start) + i;
+				
+				if (DataCompare(addr, pattern))
+				{
+					return (void*)(addr);
+				}
+			}
+
+			return nullptr;
+		}
+
+		/*
+			The first and last known bytes of a pattern, used to filter
+			candidate offsets before doing a full comparison.
+		*/
+		struct PatternAnchors
+		{
+			PatternAnchors(const HAP::BytePattern& pattern)
+			{
+				for (size_t i = 0; i < pattern.Length; i++)
+				{
+					if (!pattern.IsKnown(i))
+					{
+						continue;
+					}
+
+					if (!Valid)
+					{
+						First = i;
+						Valid = true;
+					}
+
+					Last = i;
+				}
+			}
+
+			size_t First = 0;
+			size_t Last = 0;
+			bool Valid = false;
+		};
+
+		inline bool MaskedCompare(const uint8_t* data, const HAP::BytePattern& pattern)
+		{
+			auto zero = _mm_setzero_si128();
+
+			for (size_t i = 0; i < pattern.PaddedLength; i += 16)
+			{
+				auto block = _mm_loadu_si128((const __m128i*)(data + i));
+				auto value = _mm_loadu_si128((const __m128i*)(pattern.Values + i));
+				auto mask = _mm_loadu_si128((const __m128i*)(pattern.Masks + i));
+
+				auto diff = _mm_and_si128(_mm_xor_si128(block, value), mask);
+
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, zero)) != 0xFFFF)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/*
+			Checks every candidate offset set in "bits", lowest first. The vector compare
+			reads the whole padded pattern so it can only be used when that stays inside the image.
+		*/
+		inline const uint8_t* TestCandidates(const uint8_t* start, size_t searchlength, size_t base, uint32_t bits, const HAP::BytePattern& pattern)
+		{
+			auto lastpos = searchlength - pattern.Length;
+
+			while (bits)
+			{
+				auto index = CountTrailingZeros(bits);
+				bits &= bits - 1;
+
+				auto pos = base + index;
+
+				if (pos > lastpos)
+				{
+					break;
+				}
+
+				auto addr = start + pos;
+
+				if (pos + pattern.PaddedLength <= searchlength)
+				{
+					if (MaskedCompare(addr, pattern))
+					{
+						return addr;
+					}
+				}
+
+				else if (DataCompare(addr, pattern))
+				{
+					return addr;
+				}
+			}
+
+			return nullptr;
+		}
+
+		template <size_t BlockSize, typename Finder>
+		void* FindPatternBlocks(void* start, size_t searchlength, const HAP::BytePattern& pattern, Finder&& finder)
+		{
+			PatternAnchors anchors(pattern);
+
+			auto data = static_cast<const uint8_t*>(start);
+			auto lastpos = searchlength - pattern.Length;
+
+			size_t i = 0;
+
+			for (; i + anchors.Last + BlockSize <= searchlength && i <= lastpos; i += BlockSize)
+			{
+				auto bits = finder(data + i, pattern, anchors);
+
+				if (bits)
+				{
+					auto ret = TestCandidates(data, searchlength, i, bits, pattern);
+
+					if (ret)
+					{
+						return (void*)(ret);
+					}
+				}
+			}
+
+			for (; i <= lastpos; ++i)
+			{
+				auto addr = data + i;
+
+				if (DataCompare(addr, pattern))
+				{
+					return (void*)(addr);
+				}
+			}
+
+			return nullptr;
+		}
+
+		void* FindPatternSSE2(void* start, size_t searchlength, const HAP::BytePattern& pattern)
+		{
+			return FindPatternBlocks<16>(start, searchlength, pattern, [](const uint8_t* data, const HAP::BytePattern& pattern, const PatternAnchors& anchors) -> uint32_t
+			{
+				auto first = _mm_set1_epi8(pattern.Values[anchors.First]);
+				auto last = _mm_set1_epi8(pattern.Values[anchors.Last]);
+
+				auto firstblock = _mm_loadu_si128((const __m128i*)(data + anchors.First));
+				auto lastblock = _mm_loadu_si128((const __m128i*)(data + anchors.Last));
+
+				auto eq = _mm_and_si128(_mm_cmpeq_epi8(firstblock, first), _mm_cmpeq_epi8(lastblock, last));
+
+				return _mm_movemask_epi8(eq);
+			});
+		}
+
+		/*
+			Separate function object so only this part is compiled for AVX2 on compilers
+			that need it enabled per function.
+		*/
+		struct AVX2Finder
+		{
+			HAP_TARGET_AVX2 uint32_t operator()(const uint8_t* data, const HAP::BytePattern& pattern, const PatternAnchors& anchors) const
+			{
+				auto first = _mm256_set1_epi8(pattern.Values[anchors.First]);
+				auto last = _mm256_set1_epi8(pattern.Values[anchors.Last]);
+
+				auto firstblock = _mm256_loadu_si256((const __m256i*)(data + anchors.First));
+				auto lastblock = _mm256_loadu_si256((const __m256i*)(data + anchors.Last));
+
+				auto eq = _mm256_and_si256(_mm256_cmpeq_epi8(firstblock, first), _mm256_cmpeq_epi8(lastblock, last));
+
+				return _mm256_movemask_epi8(eq);
+			}
+		};
+
+		void* FindPatternAVX2(void* start, size_t searchlength, const HAP::BytePattern& pattern)
+		{
+			return FindPatternBlocks<32>(start, searchlength, pattern, AVX2Finder());
+		}
+
+		bool IsAVX2Supported()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+
+			if (info[0] < 7)
+			{
+				return false;
+			}
+
+			__cpuid(info, 1);
+
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+
+			if (!osxsave || !avx)
+			{
+				return false;
+			}
+
+			/*
+				The OS has to save the YMM registers on context switches.
+			*/
+			if ((_xgetbv(0) & 6) != 6)
+			{
+				return false;
+			}
+
+			__cpuidex(info, 7, 0);
+
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") != 0;
+#endif
+		}
+
+		void* FindPatternVector(void* start, size_t searchlength, const HAP::BytePattern& pattern)
+		{
+			static const bool avx2 = IsAVX2Supported();
+
+			auto length = pattern.Length;
+
+			if (length == 0 || length > searchlength)
+			{
+				return nullptr;
+			}
+
+			/*
+				Nothing to filter candidates on.
+			*/
+			if (!PatternAnchors(pattern).Valid)
+			{
+				return FindPatternScalar(start, searchlength, pattern);
+			}
+
+			if (avx2)
+			{
+				return FindPatternAVX2(start, searchlength, pattern);
+			}
+
+			return FindPatternSSE2(start, searchlength, pattern);
+		}
+
+		/*
+			Horspool search on the longest run of known bytes in the pattern, the rest of
+			the pattern is only compared where that run matches. A mismatch lets the search skip
+			ahead by up to the run length. Later runs are preferred on equal length since
+			signatures tend to end in the more unique bytes.
+		*/
+		void* FindPatternHorspool(void* start, size_t searchlength, const HAP::BytePattern& pattern)
+		{
+			auto length = pattern.Length;
+
+			if (length == 0 || length > searchlength)
+			{
+				return nullptr;
+			}
+
+			size_t runstart = 0;
+			size_t runlength = 0;
+
+			for (size_t i = 0; i < length;)
+			{
+				if (!pattern.IsKnown(i))
+				{
+					++i;
+					continue;
+				}
+
+				auto first = i;
+
+				while (i < length && pattern.IsKnown(i))
+				{
+					++i;
+				}
+
+				if (i - first >= runlength)
+				{
+					runstart = first;
+					runlength = i - first;
+				}
+			}
+
+			/*
+				Nothing to skip with.
+			*/
+			if (runlength < 2)
+			{
+				return FindPatternVector(start, searchlength, pattern);
+			}
+
+			size_t skip[256];
+
+			for (auto& value : skip)
+			{
+				value = runlength;
+			}
+
+			auto run = pattern.Values + runstart;
+
+			for (size_t i = 0; i < runlength - 1; i++)
+			{
+				skip[run[i]] = runlength - 1 - i;
+			}
+
+			auto data = static_cast<const uint8_t*>(start);
+			auto lastpos = searchlength - length;
+			auto lastvalue = run[runlength - 1];
+
+			for (size_t pos = 0; pos <= lastpos;)
+			{
+				auto segment = data + pos + runstart;
+				auto tail = segment[runlength - 1];
+
+				if (tail == lastvalue && std::memcmp(segment, run, runlength - 1) == 0)
+				{
+					if (DataCompare(data + pos, pattern))
+					{
+						return (void*)(data + pos);
+					}
+				}
+
+				pos += skip[tail];
+			}
+
+			return nullptr;
+		}
+
+		void* FindPattern(void* start, size_t searchlength, const HAP::BytePattern& pattern, HAP::PatternScanEngine engine)
+		{
+			switch (engine)
+			{
+				case HAP::PatternScanEngine::Horspool:
+				{
+					return FindPatternHorspool(start, searchlength, pattern);
+				}
+
+				case HAP::PatternScanEngine::Scalar:
+				{
+					return FindPatternScalar(start, searchlength, pattern);
+				}
+
+				case HAP::PatternScanEngine::Vector:
+				{
+					break;
+				}
+			}
+
+			return FindPatternVector(start, searchlength, pattern);
+		}
+
+		/*
+			Bytes that show up all over x86 code and make poor anchors.
+		*/
+		inline bool IsCommonCodeByte(uint8_t value)
+		{
+			switch (value)
+			{
+				case 0x00:
+				case 0xFF:
+				case 0xCC:
+				case 0x55:
+				case 0x8B:
+				case 0x89:
+				case 0x8D:
+				case 0x83:
+				case 0x85:
+				case 0xE8:
+				case 0x90:
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		struct MultiPatternEntry
+		{
+			const HAP::BytePattern* Pattern;
+			size_t Index;
+
+			/*
+				Two adjacent known bytes at this offset into the pattern
+				are used as the lookup key during the scan.
+			*/
+			size_t AnchorOffset;
+			uint16_t Key;
+		};
+
+		bool GetPatternAnchor(const HAP::BytePattern& pattern, size_t& offset, uint16_t& key)
+		{
+			int bestscore = 3;
+
+			for (size_t i = 0; i + 1 < pattern.Length; i++)
+			{
+				if (!pattern.IsKnown(i) || !pattern.IsKnown(i + 1))
+				{
+					continue;
+				}
+
+				auto first = pattern.Values[i];
+				auto second = pattern.Values[i + 1];
+
+				int score = IsCommonCodeByte(first) + IsCommonCodeByte(second);
+
+				if (score < bestscore)
+				{
+					bestscore = score;
+					offset = i;
+					key = first | (second << 8);
+
+					if (score == 0)
+					{
+						break;
+					}
+				}
+			}
+
+			return bestscore != 3;
+		}
+
+		/*
+			Bucket bits for both anchor bytes by their low and high nibbles. A position
+			is a candidate for a bucket when all four lookups have its bit set, which
+			is exact for a bucket with one anchor and close to it for a few.
+		*/
+		struct AnchorTables
+		{
+			alignas(16) uint8_t Low0[16];
+			alignas(16) uint8_t High0[16];
+			alignas(16) uint8_t Low1[16];
+			alignas(16) uint8_t High1[16];
+
+			uint8_t Get(uint8_t first, uint8_t second) const
+			{
+				return Low0[first & 15] & High0[first >> 4] & Low1[second & 15] & High1[second >> 4];
+			}
+		};
+
+		struct AVX2AnchorFinder
+		{
+			/*
+				Goes through 32 positions at a time from "pos" until one has a candidate, then
+				returns that block with the bucket bits of each position in "buckets". Stops at
+				or after "end" with no candidates otherwise.
+			*/
+			HAP_TARGET_AVX2 size_t operator()(const uint8_t* data, size_t pos, size_t end, const AnchorTables& tables, uint8_t* buckets, uint32_t& candidates) const
+			{
+				auto low0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)tables.Low0));
+				auto high0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)tables.High0));
+				auto low1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)tables.Low1));
+				auto high1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)tables.High1));
+
+				auto nibble = _mm256_set1_epi8(0x0F);
+				auto zero = _mm256_setzero_si256();
+
+				for (; pos < end; pos += 32)
+				{
+					auto first = _mm256_loadu_si256((const __m256i*)(data + pos));
+					auto second = _mm256_loadu_si256((const __m256i*)(data + pos + 1));
+
+					auto firstbits = _mm256_and_si256(
+						_mm256_shuffle_epi8(low0, _mm256_and_si256(first, nibble)),
+						_mm256_shuffle_epi8(high0, _mm256_and_si256(_mm256_srli_epi16(first, 4), nibble)));
+
+					auto secondbits = _mm256_and_si256(
+						_mm256_shuffle_epi8(low1, _mm256_and_si256(second, nibble)),
+						_mm256_shuffle_epi8(high1, _mm256_and_si256(_mm256_srli_epi16(second, 4), nibble)));
+
+					auto bits = _mm256_and_si256(firstbits, secondbits);
+					auto mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bits, zero)));
+
+					if (mask)
+					{
+						_mm256_storeu_si256((__m256i*)buckets, bits);
+						candidates = mask;
+
+						return pos;
+					}
+				}
+
+				candidates = 0;
+				return pos;
+			}
+		};
+
+		/*
+			Anchors are spread over 8 buckets that are all filtered for at once, 32 positions
+			at a time. Only positions with candidates are compared against the patterns in the
+			matching buckets. Positions are visited in order so each pattern gets the same
+			(lowest) address as FindPattern.
+
+			Without AVX2 there is no byte shuffle to filter with, one vector scan
+			per pattern is faster then.
+		*/
+		std::vector<void*> FindPatterns(void* start, size_t searchlength, const std::vector<const HAP::BytePattern*>& patterns, HAP::PatternScanEngine engine)
+		{
+			enum
+			{
+				BucketCount = 8
+			};
+
+			static const bool avx2 = IsAVX2Supported();
+
+			std::vector<void*> ret(patterns.size(), nullptr);
+
+			if (!avx2 || engine != HAP::PatternScanEngine::Vector)
+			{
+				for (size_t i = 0; i < patterns.size(); i++)
+				{
+					ret[i] = FindPattern(start, searchlength, *patterns[i], engine);
+				}
+
+				return ret;
+			}
+
+			std::vector<MultiPatternEntry> buckets[BucketCount];
+			std::vector<uint16_t> keys;
+
+			size_t remaining = 0;
+
+			for (size_t i = 0; i < patterns.size(); i++)
+			{
+				auto pattern = patterns[i];
+
+				MultiPatternEntry entry;
+				entry.Pattern = pattern;
+				entry.Index = i;
+
+				if (!GetPatternAnchor(*pattern, entry.AnchorOffset, entry.Key))
+				{
+					ret[i] = FindPattern(start, searchlength, *pattern, engine);
+					continue;
+				}
+
+				/*
+					Patterns with the same anchor share a bucket.
+				*/
+				auto key = std::find(keys.begin(), keys.end(), entry.Key);
+
+				if (key == keys.end())
+				{
+					key = keys.insert(keys.end(), entry.Key);
+				}
+
+				buckets[(key - keys.begin()) % BucketCount].emplace_back(entry);
+				++remaining;
+			}
+
+			AnchorTables tables;
+
+			auto buildtables = [&]()
+			{
+				std::memset(&tables, 0, sizeof(tables));
+
+				for (size_t i = 0; i < BucketCount; i++)
+				{
+					auto bit = static_cast<uint8_t>(1 << i);
+
+					for (const auto& entry : buckets[i])
+					{
+						auto first = static_cast<uint8_t>(entry.Key);
+						auto second = static_cast<uint8_t>(entry.Key >> 8);
+
+						tables.Low0[first & 15] |= bit;
+						tables.High0[first >> 4] |= bit;
+						tables.Low1[second & 15] |= bit;
+						tables.High1[second >> 4] |= bit;
+					}
+				}
+			};
+
+			buildtables();
+
+			auto data = static_cast<const uint8_t*>(start);
+
+			/*
+				Found patterns are taken out of the tables so they stop producing candidates.
+			*/
+			auto test = [&](size_t i, uint32_t bits)
+			{
+				uint16_t key = data[i] | (data[i + 1] << 8);
+				auto found = false;
+
+				while (bits)
+				{
+					auto& entries = buckets[CountTrailingZeros(bits)];
+					bits &= bits - 1;
+
+					for (auto it = entries.begin(); it != entries.end();)
+					{
+						const auto& entry = *it;
+						auto length = entry.Pattern->Length;
+
+						if (entry.Key == key && i >= entry.AnchorOffset)
+						{
+							auto pos = i - entry.AnchorOffset;
+
+							if (pos + length <= searchlength && DataCompare(data + pos, *entry.Pattern))
+							{
+								ret[entry.Index] = (void*)(data + pos);
+								it = entries.erase(it);
+
+								--remaining;
+								found = true;
+
+								continue;
+							}
+						}
+
+						++it;
+					}
+				}
+
+				if (found)
+				{
+					buildtables();
+				}
+			};
+
+			/*
+				Every block also reads the byte after it.
+			*/
+			auto end = searchlength > 32 ? searchlength - 32 : 0;
+
+			size_t i = 0;
+
+			while (remaining && i < end)
+			{
+				uint8_t bits[32];
+				uint32_t candidates;
+
+				i = AVX2AnchorFinder()(data, i, end, tables, bits, candidates);
+
+				if (!candidates)
+				{
+					break;
+				}
+
+				while (candidates && remaining)
+				{
+					auto index = CountTrailingZeros(candidates);
+					candidates &= candidates - 1;
+
+					test(i + index, bits[index]);
+				}
+
+				i += 32;
+			}
+
+			for (; remaining && i + 1 < searchlength; i++)
+			{
+				auto bits = tables.Get(data[i], data[i + 1]);
+
+				if (bits)
+				{
+					test(i, bits);
+				}
+			}
+
+			return ret;
+		}
+
+		struct ImageChunk
+		{
+			size_t Offset;
+			size_t Length;
+		};
+
+		/*
+			Splits the image into chunks of candidate start positions. Every chunk also covers
+			"overlap" bytes into the next chunk so patterns crossing a boundary are still found.
+		*/
+		std::vector<ImageChunk> SplitImage(size_t searchlength, size_t overlap, size_t workers)
+		{
+			enum : size_t
+			{
+				MinimumChunkSize = 1024 * 1024
+			};
+
+			std::vector<ImageChunk> ret;
+
+			/*
+				A few chunks per worker keeps the load balanced when some finish early.
+			*/
+			auto chunksize = std::max<size_t>(MinimumChunkSize, searchlength / (workers * 4));
+
+			for (size_t offset = 0; offset < searchlength; offset += chunksize)
+			{
+				ImageChunk chunk;
+				chunk.Offset = offset;
+				chunk.Length = std::min(chunksize + overlap, searchlength - offset);
+
+				ret.emplace_back(chunk);
+			}
+
+			return ret;
+		}
+
+		void* FindPatternParallel(void* start, size_t searchlength, const HAP::BytePattern& pattern, HAP::PatternScanEngine engine)
+		{
+			auto workers = HAP::GetWorkerCount();
+			auto length = pattern.Length;
+
+			if (length == 0 || length > searchlength)
+			{
+				return nullptr;
+			}
+
+			auto chunks = SplitImage(searchlength, length - 1, workers);
+
+			if (workers == 1 || chunks.size() == 1)
+			{
+				return FindPattern(start, searchlength, pattern, engine);
+			}
+
+			std::vector<void*> results(chunks.size(), nullptr);
+			std::atomic<size_t> lowest(chunks.size());
+
+			HAP::RunChunks(chunks.size(), workers, [&](size_t index)
+			{
+				/*
+					Already have a match in an earlier chunk.
+				*/
+				if (index > lowest)
+				{
+					return;
+				}
+
+				const auto& chunk = chunks[index];
+				auto addr = FindPattern(static_cast<uint8_t*>(start) + chunk.Offset, chunk.Length, pattern, engine);
+
+				if (!addr)
+				{
+					return;
+				}
+
+				results[index] = addr;
+
+				auto current = lowest.load();
+
+				while (index < current && !lowest.compare_exchange_weak(current, index))
+				{
+
+				}
+			});
+
+			for (auto addr : results)
+			{
+				if (addr)
+				{
+					return addr;
+				}
+			}
+
+			return nullptr;
+		}
+
+		std::vector<void*> FindPatternsParallel(void* start, size_t searchlength, const std::vector<const HAP::BytePattern*>& patterns, HAP::PatternScanEngine engine)
+		{
+			auto workers = HAP::GetWorkerCount();
+			size_t overlap = 0;
+
+			for (auto pattern : patterns)
+			{
+				if (pattern->Length)
+				{
+					overlap = std::max(overlap, pattern->Length - 1);
+				}
+			}
+
+			auto chunks = SplitImage(searchlength, overlap, workers);
+
+			if (workers == 1 || chunks.size() <= 1)
+			{
+				return FindPatterns(start, searchlength, patterns, engine);
+			}
+
+			std::vector<std::vector<void*>> results(chunks.size());
+
+			HAP::RunChunks(chunks.size(), workers, [&](size_t index)
+			{
+				const auto& chunk = chunks[index];
+				results[index] = FindPatterns(static_cast<uint8_t*>(start) + chunk.Offset, chunk.Length, patterns, engine);
+			});
+
+			std::vector<void*> ret(patterns.size(), nullptr);
+
+			for (size_t i = 0; i < patterns.size(); i++)
+			{
+				for (const auto& chunk : results)
+				{
+					if (chunk[i])
+					{
+						ret[i] = chunk[i];
+						break;
+					}
+				}
+			}
+
+			return ret;
+		}
+	}
+}
+
+HAP::BytePattern HAP::BytePatternBuffer::Get() const
+{
+	BytePattern ret;
+	ret.Values = Values.data();
+	ret.Masks = Masks.data();
+	ret.Length = Length;
+	ret.PaddedLength = Values.size();
+	ret.Captures = Captures.data();
+	ret.CaptureCount = Captures.size();
+
+	return ret;
+}
+
+HAP::BytePatternBuffer HAP::GetPatternFromString(const char* input)
+{
+	BytePatternBuffer ret;
+
+	auto capacity = PatternDetail::GetPaddedSize(std::strlen(input));
+
+	ret.Values.resize(capacity);
+	ret.Masks.resize(capacity);
+
+	/*
+		Every capture takes at least five characters.
+	*/
+	ret.Captures.resize(capacity / 5);
+
+	size_t capturecount;
+	auto length = PatternDetail::Parse(input, ret.Values.data(), ret.Masks.data(), capacity, ret.Captures.data(), ret.Captures.size(), capturecount);
+
+	if (length == PatternDetail::InvalidPattern)
+	{
+		length = 0;
+		capturecount = 0;
+	}
+
+	ret.Length = length;
+	ret.Captures.resize(capturecount);
+
+	ret.Values.resize(PatternDetail::GetPaddedSize(length));
+	ret.Masks.resize(PatternDetail::GetPaddedSize(length));
+
+	return ret;
+}
+
+bool HAP::Scanner::ComparePattern(const void* data, const BytePattern& pattern)
+{
+	return Memory::DataCompare(static_cast<const uint8_t*>(data), pattern);
+}
+
+void* HAP::Scanner::FindPatternScalar(void* start, size_t searchlength, const BytePattern& pattern)
+{
+	return Memory::FindPatternScalar(start, searchlength, pattern);
+}
+
+void* HAP::Scanner::FindPatternVector(void* start, size_t searchlength, const BytePattern& pattern)
+{
+	return Memory::FindPatternVector(start, searchlength, pattern);
+}
+
+void* HAP::Scanner::FindPatternHorspool(void* start, size_t searchlength, const BytePattern& pattern)
+{
+	return Memory::FindPatternHorspool(start, searchlength, pattern);
+}
+
+void* HAP::Scanner::FindPattern(void* start, size_t searchlength, const BytePattern& pattern, PatternScanEngine engine)
+{
+	return Memory::FindPattern(start, searchlength, pattern, engine);
+}
+
+std::vector<void*> HAP::Scanner::FindPatterns(void* start, size_t searchlength, const std::vector<const BytePattern*>& patterns, PatternScanEngine engine)
+{
+	return Memory::FindPatterns(start, searchlength, patterns, engine);
+}
+
+void* HAP::Scanner::FindPatternParallel(void* start, size_t searchlength, const BytePattern& pattern, PatternScanEngine engine)
+{
+	return Memory::FindPatternParallel(start, searchlength, pattern, engine);
+}
+
+std::vector<void*> HAP::Scanner::FindPatternsParallel(void* start, size_t searchlength, const std::vector<const BytePattern*>& patterns, PatternScanEngine engine)
+{
+	return Memory::FindPatternsParallel(start, searchlength, patterns, engine);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "BytePattern.hpp"
+
+/*
+	Signature scanning over a block of memory. Addresses returned are always
+	the lowest match regardless of engine or thread count.
+*/
+namespace HAP
+{
+	namespace Scanner
+	{
+		bool ComparePattern(const void* data, const BytePattern& pattern);
+
+		void* FindPatternScalar(void* start, size_t searchlength, const BytePattern& pattern);
+		void* FindPatternVector(void* start, size_t searchlength, const BytePattern& pattern);
+		void* FindPatternHorspool(void* start, size_t searchlength, const BytePattern& pattern);
+
+		void* FindPattern(void* start, size_t searchlength, const BytePattern& pattern, PatternScanEngine engine = PatternScanEngine::Vector);
+
+		/*
+			Resolves all patterns with one pass over the memory, the returned
+			addresses are in the same order as the input.
+		*/
+		std::vector<void*> FindPatterns(void* start, size_t searchlength, const std::vector<const BytePattern*>& patterns, PatternScanEngine engine = PatternScanEngine::Vector);
+
+		/*
+			Same as above but split over all cores.
+		*/
+		void* FindPatternParallel(void* start, size_t searchlength, const BytePattern& pattern, PatternScanEngine engine = PatternScanEngine::Vector);
+		std::vector<void*> FindPatternsParallel(void* start, size_t searchlength, const std::vector<const BytePattern*>& patterns, PatternScanEngine engine = PatternScanEngine::Vector);
+	}
+}
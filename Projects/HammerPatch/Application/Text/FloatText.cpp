@@ -0,0 +1,663 @@
+#include "FloatText.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <string>
+
+/*
+	Ryu by Ulf Adams, "Ryu: Fast Float-to-String Conversion" (PLDI 2018), for
+	single precision. The tables are 5^i and 2^k / 5^i scaled to 61 and 59 bits.
+	From https://github.com/ulfjack/ryu, see "Open Source Licenses/Ryu.txt".
+*/
+namespace
+{
+	enum
+	{
+		MantissaBits = 23,
+		ExponentBits = 8,
+		ExponentBias = 127,
+
+		Pow5InverseBitCount = 59,
+		Pow5BitCount = 61,
+	};
+
+	const uint64_t Pow5InverseSplit[31] =
+	{
+			0x0800000000000001, 0x0666666666666667, 0x051EB851EB851EB9,
+			0x04189374BC6A7EFA, 0x068DB8BAC710CB2A, 0x053E2D6238DA3C22,
+			0x0431BDE82D7B634E, 0x06B5FCA6AF2BD216, 0x055E63B88C230E78,
+			0x044B82FA09B5A52D, 0x06DF37F675EF6EAE, 0x057F5FF85E592558,
+			0x0465E6604B7A8447, 0x0709709A125DA071, 0x05A126E1A84AE6C1,
+			0x0480EBE7B9D58567, 0x0734ACA5F6226F0B, 0x05C3BD5191B525A3,
+			0x049C97747490EAE9, 0x0760F253EDB4AB0E, 0x05E72843249088D8,
+			0x04B8ED0283A6D3E0, 0x078E480405D7B966, 0x060B6CD004AC9452,
+			0x04D5F0A66A23A9DB, 0x07BCB43D769F762B, 0x063090312BB2C4EF,
+			0x04F3A68DBC8F03F3, 0x07EC3DAF94180651, 0x065697BFA9ACD1DA,
+			0x051212FFBAF0A7E2,
+	};
+
+	const uint64_t Pow5Split[47] =
+	{
+			0x1000000000000000, 0x1400000000000000, 0x1900000000000000,
+			0x1F40000000000000, 0x1388000000000000, 0x186A000000000000,
+			0x1E84800000000000, 0x1312D00000000000, 0x17D7840000000000,
+			0x1DCD650000000000, 0x12A05F2000000000, 0x174876E800000000,
+			0x1D1A94A200000000, 0x12309CE540000000, 0x16BCC41E90000000,
+			0x1C6BF52634000000, 0x11C37937E0800000, 0x16345785D8A00000,
+			0x1BC16D674EC80000, 0x1158E460913D0000, 0x15AF1D78B58C4000,
+			0x1B1AE4D6E2EF5000, 0x10F0CF064DD59200, 0x152D02C7E14AF680,
+			0x1A784379D99DB420, 0x108B2A2C28029094, 0x14ADF4B7320334B9,
+			0x19D971E4FE8401E7, 0x1027E72F1F128130, 0x1431E0FAE6D7217C,
+			0x193E5939A08CE9DB, 0x1F8DEF8808B02452, 0x13B8B5B5056E16B3,
+			0x18A6E32246C99C60, 0x1ED09BEAD87C0378, 0x13426172C74D822B,
+			0x1812F9CF7920E2B6, 0x1E17B84357691B64, 0x12CED32A16A1B11E,
+			0x178287F49C4A1D66, 0x1D6329F1C35CA4BF, 0x125DFA371A19E6F7,
+			0x16F578C4E0A060B5, 0x1CB2D6F618C878E3, 0x11EFC659CF7D4B8D,
+			0x166BB7F0435C9E71, 0x1C06A5EC5433C60D,
+	};
+
+	/*
+		Number of bits in 5^e, for e up to 3528.
+	*/
+	inline int32_t Pow5Bits(int32_t e)
+	{
+		return static_cast<int32_t>((static_cast<uint32_t>(e) * 1217359) >> 19) + 1;
+	}
+
+	/*
+		floor(log10(2^e)) and floor(log10(5^e)) for e up to 1650 and 2620.
+	*/
+	inline uint32_t Log10Pow2(int32_t e)
+	{
+		return (static_cast<uint32_t>(e) * 78913) >> 18;
+	}
+
+	inline uint32_t Log10Pow5(int32_t e)
+	{
+		return (static_cast<uint32_t>(e) * 732923) >> 20;
+	}
+
+	inline uint32_t Pow5Factor(uint32_t value)
+	{
+		uint32_t count = 0;
+
+		while (value % 5 == 0)
+		{
+			value /= 5;
+			++count;
+		}
+
+		return count;
+	}
+
+	inline bool IsMultipleOfPow5(uint32_t value, uint32_t p)
+	{
+		return Pow5Factor(value) >= p;
+	}
+
+	inline bool IsMultipleOfPow2(uint32_t value, uint32_t p)
+	{
+		return (value & ((1u << p) - 1)) == 0;
+	}
+
+	inline uint32_t MulShift(uint32_t m, uint64_t factor, int32_t shift)
+	{
+		auto low = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor);
+		auto high = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor >> 32);
+
+		auto sum = (low >> 32) + high;
+		return static_cast<uint32_t>(sum >> (shift - 32));
+	}
+
+	/*
+		The value is Digits * 10^Exponent.
+	*/
+	struct DecimalFloat
+	{
+		uint32_t Digits;
+		int32_t Exponent;
+	};
+
+	DecimalFloat ToDecimal(uint32_t mantissa, uint32_t exponent)
+	{
+		int32_t e2;
+		uint32_t m2;
+
+		if (exponent == 0)
+		{
+			e2 = 1 - ExponentBias - MantissaBits - 2;
+			m2 = mantissa;
+		}
+
+		else
+		{
+			e2 = static_cast<int32_t>(exponent) - ExponentBias - MantissaBits - 2;
+			m2 = (1u << MantissaBits) | mantissa;
+		}
+
+		auto acceptbounds = (m2 & 1) == 0;
+
+		/*
+			The value and the halfway points to its neighbours, all times 4.
+		*/
+		uint32_t mv = 4 * m2;
+		uint32_t mp = 4 * m2 + 2;
+		uint32_t mmshift = mantissa != 0 || exponent <= 1;
+		uint32_t mm = 4 * m2 - 1 - mmshift;
+
+		uint32_t vr;
+		uint32_t vp;
+		uint32_t vm;
+		int32_t e10;
+
+		auto vmtrailingzeros = false;
+		auto vrtrailingzeros = false;
+		uint32_t lastremoved = 0;
+
+		if (e2 >= 0)
+		{
+			auto q = Log10Pow2(e2);
+			e10 = static_cast<int32_t>(q);
+
+			auto k = Pow5InverseBitCount + Pow5Bits(q) - 1;
+			auto i = -e2 + static_cast<int32_t>(q) + k;
+
+			vr = MulShift(mv, Pow5InverseSplit[q], i);
+			vp = MulShift(mp, Pow5InverseSplit[q], i);
+			vm = MulShift(mm, Pow5InverseSplit[q], i);
+
+			if (q != 0 && (vp - 1) / 10 <= vm / 10)
+			{
+				/*
+					One removed digit is needed for rounding even if the loop below does not run.
+				*/
+				auto l = Pow5InverseBitCount + Pow5Bits(q - 1) - 1;
+				lastremoved = MulShift(mv, Pow5InverseSplit[q - 1], -e2 + static_cast<int32_t>(q) - 1 + l) % 10;
+			}
+
+			if (q <= 9)
+			{
+				/*
+					Only one of mp, mv and mm can be a multiple of 5, if any.
+				*/
+				if (mv % 5 == 0)
+				{
+					vrtrailingzeros = IsMultipleOfPow5(mv, q);
+				}
+
+				else if (acceptbounds)
+				{
+					vmtrailingzeros = IsMultipleOfPow5(mm, q);
+				}
+
+				else
+				{
+					vp -= IsMultipleOfPow5(mp, q);
+				}
+			}
+		}
+
+		else
+		{
+			auto q = Log10Pow5(-e2);
+			e10 = static_cast<int32_t>(q) + e2;
+
+			auto i = -e2 - static_cast<int32_t>(q);
+			auto k = Pow5Bits(i) - Pow5BitCount;
+			auto j = static_cast<int32_t>(q) - k;
+
+			vr = MulShift(mv, Pow5Split[i], j);
+			vp = MulShift(mp, Pow5Split[i], j);
+			vm = MulShift(mm, Pow5Split[i], j);
+
+			if (q != 0 && (vp - 1) / 10 <= vm / 10)
+			{
+				j = static_cast<int32_t>(q) - 1 - (Pow5Bits(i + 1) - Pow5BitCount);
+				lastremoved = MulShift(mv, Pow5Split[i + 1], j) % 10;
+			}
+
+			if (q <= 1)
+			{
+				/*
+					mv = 4 * m2 always has at least two trailing zero bits.
+				*/
+				vrtrailingzeros = true;
+
+				if (acceptbounds)
+				{
+					vmtrailingzeros = mmshift == 1;
+				}
+
+				else
+				{
+					--vp;
+				}
+			}
+
+			else if (q < 31)
+			{
+				vrtrailingzeros = IsMultipleOfPow2(mv, q - 1);
+			}
+		}
+
+		/*
+			Remove digits for as long as the result stays between the halfway points.
+		*/
+		int32_t removed = 0;
+		uint32_t output;
+
+		if (vmtrailingzeros || vrtrailingzeros)
+		{
+			while (vp / 10 > vm / 10)
+			{
+				vmtrailingzeros &= vm % 10 == 0;
+				vrtrailingzeros &= lastremoved == 0;
+
+				lastremoved = vr % 10;
+
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				++removed;
+			}
+
+			if (vmtrailingzeros)
+			{
+				while (vm % 10 == 0)
+				{
+					vrtrailingzeros &= lastremoved == 0;
+
+					lastremoved = vr % 10;
+
+					vr /= 10;
+					vp /= 10;
+					vm /= 10;
+					++removed;
+				}
+			}
+
+			/*
+				Exactly halfway rounds to even.
+			*/
+			if (vrtrailingzeros && lastremoved == 5 && vr % 2 == 0)
+			{
+				lastremoved = 4;
+			}
+
+			output = vr + ((vr == vm && (!acceptbounds || !vmtrailingzeros)) || lastremoved >= 5);
+		}
+
+		else
+		{
+			while (vp / 10 > vm / 10)
+			{
+				lastremoved = vr % 10;
+
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				++removed;
+			}
+
+			output = vr + (vr == vm || lastremoved >= 5);
+		}
+
+		DecimalFloat ret;
+		ret.Digits = output;
+		ret.Exponent = e10 + removed;
+
+		return ret;
+	}
+
+	inline size_t GetDigitCount(uint32_t value)
+	{
+		size_t ret = 1;
+
+		while (value >= 10)
+		{
+			value /= 10;
+			++ret;
+		}
+
+		return ret;
+	}
+
+	inline void WriteDigits(uint32_t value, char* dest, size_t count)
+	{
+		for (size_t i = count; i > 0; i--)
+		{
+			dest[i - 1] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		}
+	}
+
+	inline char* WriteString(char* dest, const char* text)
+	{
+		auto length = std::strlen(text);
+		std::memcpy(dest, text, length);
+
+		return dest + length;
+	}
+}
+
+size_t HAP::FloatText::Format(float value, char* dest)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	auto mantissa = bits & ((1u << MantissaBits) - 1);
+	auto exponent = (bits >> MantissaBits) & ((1u << ExponentBits) - 1);
+	auto sign = (bits >> (MantissaBits + ExponentBits)) != 0;
+
+	auto start = dest;
+
+	if (exponent == (1u << ExponentBits) - 1)
+	{
+		if (mantissa != 0)
+		{
+			return WriteString(dest, "nan") - start;
+		}
+
+		return WriteString(dest, sign ? "-inf" : "inf") - start;
+	}
+
+	if (sign)
+	{
+		*dest++ = '-';
+	}
+
+	if (exponent == 0 && mantissa == 0)
+	{
+		*dest++ = '0';
+		return dest - start;
+	}
+
+	auto decimal = ToDecimal(mantissa, exponent);
+
+	auto length = static_cast<int32_t>(GetDigitCount(decimal.Digits));
+
+	/*
+		Position of the first digit, as in 1.5e+03.
+	*/
+	auto point = length + decimal.Exponent - 1;
+
+	/*
+		The same choice as "%g", with the precision raised to however many digits are needed.
+	*/
+	if (point < -4 || point >= std::max(length, 6))
+	{
+		WriteDigits(decimal.Digits, dest + 1, length);
+
+		dest[0] = dest[1];
+		dest++;
+
+		if (length > 1)
+		{
+			*dest = '.';
+			dest += length;
+		}
+
+		*dest++ = 'e';
+		*dest++ = point < 0 ? '-' : '+';
+
+		auto absolute = static_cast<uint32_t>(point < 0 ? -point : point);
+		auto digits = absolute >= 10 ? 2 : 1;
+
+		if (digits == 1)
+		{
+			*dest++ = '0';
+		}
+
+		WriteDigits(absolute, dest, digits);
+		dest += digits;
+	}
+
+	else if (point < 0)
+	{
+		dest = WriteString(dest, "0.");
+
+		for (int32_t i = -1; i > point; i--)
+		{
+			*dest++ = '0';
+		}
+
+		WriteDigits(decimal.Digits, dest, length);
+		dest += length;
+	}
+
+	else if (decimal.Exponent >= 0)
+	{
+		WriteDigits(decimal.Digits, dest, length);
+		dest += length;
+
+		for (int32_t i = 0; i < decimal.Exponent; i++)
+		{
+			*dest++ = '0';
+		}
+	}
+
+	else
+	{
+		/*
+			The point goes somewhere between the digits.
+		*/
+		auto whole = point + 1;
+
+		WriteDigits(decimal.Digits, dest, length);
+		std::memmove(dest + whole + 1, dest + whole, length - whole);
+
+		dest[whole] = '.';
+		dest += length + 1;
+	}
+
+	return dest - start;
+}
+
+namespace
+{
+	/*
+		Every power of 10 up to here is exact as a double.
+	*/
+	const double ExactPowersOf10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	inline bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline bool MatchWord(const char* first, const char* last, const char* word)
+	{
+		auto length = std::strlen(word);
+		return static_cast<size_t>(last - first) >= length && std::memcmp(first, word, length) == 0;
+	}
+
+	float ParseSlow(const char* first, const char* end)
+	{
+		std::string text(first, end);
+		return std::strtof(text.c_str(), nullptr);
+	}
+}
+
+const char* HAP::FloatText::Parse(const char* first, const char* last, float& value)
+{
+	auto cur = first;
+	auto negative = false;
+
+	if (cur != last && (*cur == '-' || *cur == '+'))
+	{
+		negative = *cur == '-';
+		++cur;
+	}
+
+	if (cur != last && !IsDigit(*cur))
+	{
+		if (MatchWord(cur, last, "inf"))
+		{
+			value = negative ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+			return cur + 3;
+		}
+
+		if (MatchWord(cur, last, "nan"))
+		{
+			value = std::numeric_limits<float>::quiet_NaN();
+			return cur + 3;
+		}
+	}
+
+	/*
+		The value is mantissa * 10^exponent. Digits that do not fit are only
+		kept track of, such numbers are left to the slow path.
+	*/
+	uint64_t mantissa = 0;
+	int32_t exponent = 0;
+	int32_t digits = 0;
+
+	auto anydigits = false;
+	auto truncated = false;
+
+	for (; cur != last && IsDigit(*cur); ++cur)
+	{
+		anydigits = true;
+		auto digit = static_cast<uint32_t>(*cur - '0');
+
+		if (mantissa == 0 && digit == 0)
+		{
+			continue;
+		}
+
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + digit;
+			++digits;
+		}
+
+		else
+		{
+			++exponent;
+			truncated |= digit != 0;
+		}
+	}
+
+	if (cur != last && *cur == '.')
+	{
+		++cur;
+
+		for (; cur != last && IsDigit(*cur); ++cur)
+		{
+			anydigits = true;
+			auto digit = static_cast<uint32_t>(*cur - '0');
+
+			if (mantissa == 0 && digit == 0)
+			{
+				--exponent;
+			}
+
+			else if (digits < 19)
+			{
+				mantissa = mantissa * 10 + digit;
+				++digits;
+				--exponent;
+			}
+
+			else
+			{
+				truncated |= digit != 0;
+			}
+		}
+	}
+
+	if (!anydigits)
+	{
+		return nullptr;
+	}
+
+	/*
+		An "e" without digits after it is not part of the number.
+	*/
+	if (cur != last && (*cur == 'e' || *cur == 'E'))
+	{
+		auto exp = cur + 1;
+		auto expnegative = false;
+
+		if (exp != last && (*exp == '-' || *exp == '+'))
+		{
+			expnegative = *exp == '-';
+			++exp;
+		}
+
+		if (exp != last && IsDigit(*exp))
+		{
+			int32_t written = 0;
+
+			for (; exp != last && IsDigit(*exp); ++exp)
+			{
+				if (written < 100000)
+				{
+					written = written * 10 + (*exp - '0');
+				}
+			}
+
+			exponent += expnegative ? -written : written;
+			cur = exp;
+		}
+	}
+
+	if (mantissa == 0)
+	{
+		value = negative ? -0.0f : 0.0f;
+		return cur;
+	}
+
+	/*
+		Both the mantissa and the power of 10 are exact doubles, so the one operation
+		rounds correctly to double (Clinger). Rounding that to float again is only wrong
+		when it lands exactly halfway between two floats, which is then done the slow way.
+		The result is always a normal float here.
+	*/
+	if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+	{
+		auto result = static_cast<double>(mantissa);
+
+		if (exponent < 0)
+		{
+			result /= ExactPowersOf10[-exponent];
+		}
+
+		else
+		{
+			result *= ExactPowersOf10[exponent];
+		}
+
+		uint64_t bits;
+		std::memcpy(&bits, &result, sizeof(bits));
+
+		enum
+		{
+			/*
+				Double mantissa bits below the last float mantissa bit.
+			*/
+			ExtraBits = 52 - MantissaBits
+		};
+
+		const uint64_t extramask = (1ull << ExtraBits) - 1;
+		const uint64_t halfway = 1ull << (ExtraBits - 1);
+
+		if ((bits & extramask) != halfway)
+		{
+			auto single = static_cast<float>(result);
+			value = negative ? -single : single;
+
+			return cur;
+		}
+	}
+
+	value = ParseSlow(first, cur);
+	return cur;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+
+namespace HAP
+{
+	namespace FloatText
+	{
+		enum
+		{
+			/*
+				Longest possible output, such as "-1.17549435e-38".
+			*/
+			MaxLength = 16
+		};
+
+		/*
+			Writes the shortest text that reads back as exactly the same float and returns
+			its length. Values that "%g" could already show exactly come out the same as
+			before. Nothing is null terminated and the locale is not involved.
+		*/
+		size_t Format(float value, char* dest);
+
+		/*
+			Reads a decimal float such as the ones written above or by "%g", rounded correctly.
+			Returns where the number ends, or nullptr if there is no number at "first". Numbers
+			with more than 19 digits or very large or small exponents are left to "strtof".
+		*/
+		const char* Parse(const char* first, const char* last, float& value);
+	}
+}
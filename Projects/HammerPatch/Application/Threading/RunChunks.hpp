@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace HAP
+{
+	inline size_t GetWorkerCount()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/*
+		Calls "func" with every chunk index, spread out over worker threads. Chunks are handed
+		out in order so lower chunks are always started first. The calling thread is one of the
+		workers and everything is done when this returns.
+	*/
+	template <typename Func>
+	void RunChunks(size_t count, size_t workers, Func&& func)
+	{
+		std::atomic<size_t> next(0);
+
+		auto worker = [&]()
+		{
+			while (true)
+			{
+				auto index = next++;
+
+				if (index >= count)
+				{
+					break;
+				}
+
+				func(index);
+			}
+		};
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		auto threadcount = std::min(workers, count) - 1;
+
+		for (size_t i = 0; i < threadcount; i++)
+		{
+			threads.emplace_back(worker);
+		}
+
+		worker();
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
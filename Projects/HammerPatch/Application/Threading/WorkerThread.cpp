@@ -0,0 +1,96 @@
+#include "WorkerThread.hpp"
+
+HAP::WorkerThread::~WorkerThread()
+{
+	/*
+		Static instances are destroyed while the library unloads, when the thread
+		may already be gone and joining it is not allowed.
+	*/
+	if (Thread.joinable())
+	{
+		Thread.detach();
+	}
+}
+
+void HAP::WorkerThread::Run(TaskType task)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	Signal.wait(lock, [this]()
+	{
+		return !Busy;
+	});
+
+	Task = std::move(task);
+	Busy = true;
+
+	if (!Thread.joinable())
+	{
+		Quit = false;
+		Thread = std::thread(&WorkerThread::Loop, this);
+	}
+
+	lock.unlock();
+	Signal.notify_all();
+}
+
+void HAP::WorkerThread::Wait()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	Signal.wait(lock, [this]()
+	{
+		return !Busy;
+	});
+}
+
+void HAP::WorkerThread::Stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+
+		Signal.wait(lock, [this]()
+		{
+			return !Busy;
+		});
+
+		Quit = true;
+	}
+
+	Signal.notify_all();
+
+	if (Thread.joinable())
+	{
+		Thread.join();
+	}
+}
+
+void HAP::WorkerThread::Loop()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	while (true)
+	{
+		Signal.wait(lock, [this]()
+		{
+			return Busy || Quit;
+		});
+
+		if (Busy)
+		{
+			auto task = std::move(Task);
+			Task = nullptr;
+
+			lock.unlock();
+			task();
+			lock.lock();
+
+			Busy = false;
+			Signal.notify_all();
+
+			continue;
+		}
+
+		return;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace HAP
+{
+	/*
+		A single thread that runs one task at a time in the background. The thread
+		is started on the first task and stays around until "Stop" is called.
+	*/
+	class WorkerThread
+	{
+	public:
+		using TaskType = std::function<void()>;
+
+		WorkerThread() = default;
+		~WorkerThread();
+
+		WorkerThread(const WorkerThread&) = delete;
+		WorkerThread& operator=(const WorkerThread&) = delete;
+
+		/*
+			Waits for the previous task to finish before the new one is handed over.
+		*/
+		void Run(TaskType task);
+
+		/*
+			Returns once no task is queued or running.
+		*/
+		void Wait();
+
+		/*
+			Finishes the current task and ends the thread. A later "Run" starts it again.
+		*/
+		void Stop();
+
+	private:
+		void Loop();
+
+		std::thread Thread;
+
+		std::mutex Mutex;
+		std::condition_variable Signal;
+
+		TaskType Task;
+
+		bool Busy = false;
+		bool Quit = false;
+	};
+}
@@ -2,6 +2,7 @@
 
 #include "TargetVersion.hpp"
 
+#define NOMINMAX
 #include <windows.h>
 #include <Shlwapi.h>
 #include <Psapi.h>
@@ -9,8 +10,10 @@
 #include <wrl.h>
 
 #include <vector>
+#include <string>
 #include <memory>
 #include <thread>
+#include <atomic>
 #include <chrono>
 #include <initializer_list>
 #include <stdint.h>
@@ -0,0 +1,355 @@
+#include "Benchmarks.hpp"
+
+#include "Application/Scanner/PatternScanner.hpp"
+#include "Application/Modules/Save Load/SaveLoadSignatures.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <chrono>
+
+namespace
+{
+	struct EngineInfo
+	{
+		const char* Name;
+		HAP::PatternScanEngine Engine;
+	};
+
+	/*
+		Every engine in here is measured and checked against the scalar reference.
+	*/
+	const EngineInfo Engines[] =
+	{
+		{ "scalar", HAP::PatternScanEngine::Scalar },
+		{ "vector", HAP::PatternScanEngine::Vector },
+		{ "horspool", HAP::PatternScanEngine::Horspool },
+	};
+
+	struct Options
+	{
+		size_t ImageSize = 32 * 1024 * 1024;
+		int Repetitions = 3;
+		uint32_t Seed = 1;
+	};
+
+	/*
+		Random bytes weighted towards common x86 opcodes and prologues so the
+		candidate filters see hit rates close to a real code section.
+	*/
+	void FillCode(std::vector<uint8_t>& data, std::mt19937& rng)
+	{
+		static const uint8_t common[] =
+		{
+			0x00, 0xFF, 0xCC, 0x55, 0x8B, 0x89, 0x8D, 0x83, 0x85, 0xE8, 0x90, 0xEC, 0x04, 0x08, 0xC4, 0x50
+		};
+
+		static const uint8_t prologue[] =
+		{
+			0x55, 0x8B, 0xEC
+		};
+
+		std::uniform_int_distribution<int> kind(0, 99);
+		std::uniform_int_distribution<int> byte(0, 255);
+		std::uniform_int_distribution<int> commonindex(0, sizeof(common) - 1);
+
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			auto roll = kind(rng);
+
+			if (roll < 2 && i + sizeof(prologue) <= data.size())
+			{
+				std::memcpy(&data[i], prologue, sizeof(prologue));
+				i += sizeof(prologue) - 1;
+			}
+
+			else if (roll < 50)
+			{
+				data[i] = common[commonindex(rng)];
+			}
+
+			else
+			{
+				data[i] = static_cast<uint8_t>(byte(rng));
+			}
+		}
+	}
+
+	/*
+		Places every pattern in the last quarter of the image so each
+		search has to go through most of it. Wildcards get random bytes.
+	*/
+	void PlantPatterns(std::vector<uint8_t>& data, const std::vector<HAP::NamedPattern>& patterns, std::mt19937& rng)
+	{
+		auto regionstart = data.size() - data.size() / 4;
+		std::uniform_int_distribution<size_t> position(regionstart, data.size() - 256);
+		std::uniform_int_distribution<int> byte(0, 255);
+
+		for (const auto& entry : patterns)
+		{
+			const auto& pattern = entry.Pattern;
+			auto pos = position(rng);
+
+			for (size_t i = 0; i < pattern.Length; i++)
+			{
+				data[pos + i] = pattern.IsKnown(i) ? pattern.Values[i] : static_cast<uint8_t>(byte(rng));
+			}
+		}
+	}
+
+	/*
+		Best of all repetitions, in seconds.
+	*/
+	template <typename Func>
+	double Measure(int repetitions, Func&& func)
+	{
+		double best = 1e30;
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			func();
+			auto end = std::chrono::high_resolution_clock::now();
+
+			auto seconds = std::chrono::duration<double>(end - start).count();
+
+			if (seconds < best)
+			{
+				best = seconds;
+			}
+		}
+
+		return best;
+	}
+
+	double GetThroughput(size_t bytes, double seconds)
+	{
+		return (bytes / seconds) / (1024.0 * 1024.0 * 1024.0);
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			auto arg = argv[i];
+			auto hasvalue = i + 1 < argc;
+
+			if (std::strcmp(arg, "-size") == 0 && hasvalue)
+			{
+				options.ImageSize = std::strtoul(argv[++i], nullptr, 10) * 1024 * 1024;
+			}
+
+			else if (std::strcmp(arg, "-reps") == 0 && hasvalue)
+			{
+				options.Repetitions = std::atoi(argv[++i]);
+			}
+
+			else if (std::strcmp(arg, "-seed") == 0 && hasvalue)
+			{
+				options.Seed = std::strtoul(argv[++i], nullptr, 10);
+			}
+
+			else
+			{
+				std::printf("Usage: %s [-size megabytes] [-reps count] [-seed value]\n", argv[0]);
+				std::printf("       %s vertices [-reps count] [-seed value]\n", argv[0]);
+				std::printf("       %s floats [-count values] [-reps count] [-seed value]\n", argv[0]);
+				return false;
+			}
+		}
+
+		if (options.ImageSize < 1024 * 1024 || options.Repetitions < 1)
+		{
+			std::printf("Image must be at least 1 MB and repetitions at least 1\n");
+			return false;
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2 && std::strcmp(argv[1], "vertices") == 0)
+	{
+		return RunVertexBenchmark(argc - 2, argv + 2);
+	}
+
+	if (argc >= 2 && std::strcmp(argv[1], "floats") == 0)
+	{
+		return RunFloatBenchmark(argc - 2, argv + 2);
+	}
+
+	Options options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	auto patterns = HAP::SaveLoadSignatures::GetAll();
+
+	std::mt19937 rng(options.Seed);
+
+	std::vector<uint8_t> image(options.ImageSize);
+	FillCode(image, rng);
+	PlantPatterns(image, patterns, rng);
+
+	auto start = image.data();
+	auto size = image.size();
+
+	std::printf("Image: %zu MB, %zu patterns, best of %d\n\n", size / (1024 * 1024), patterns.size(), options.Repetitions);
+
+	std::vector<void*> reference;
+
+	for (const auto& entry : patterns)
+	{
+		reference.emplace_back(HAP::Scanner::FindPatternScalar(start, size, entry.Pattern));
+	}
+
+	bool mismatch = false;
+
+	std::printf("%-30s %-5s %-9s %10s %10s\n", "Pattern", "Game", "Engine", "ms", "GB/s");
+
+	for (size_t i = 0; i < patterns.size(); i++)
+	{
+		const auto& entry = patterns[i];
+
+		/*
+			Only the bytes up to the match have to be looked at.
+		*/
+		auto scanned = reference[i] ? static_cast<uint8_t*>(reference[i]) - start + entry.Pattern.Length : size;
+
+		for (const auto& engine : Engines)
+		{
+			void* result = nullptr;
+
+			auto seconds = Measure(options.Repetitions, [&]()
+			{
+				result = HAP::Scanner::FindPattern(start, size, entry.Pattern, engine.Engine);
+			});
+
+			if (result != reference[i])
+			{
+				std::printf("Mismatch: %s %s with engine %s\n", entry.Name, entry.Game, engine.Name);
+				mismatch = true;
+			}
+
+			std::printf("%-30s %-5s %-9s %10.3f %10.2f\n", entry.Name, entry.Game, engine.Name, seconds * 1000.0, GetThroughput(scanned, seconds));
+		}
+	}
+
+	std::vector<const HAP::BytePattern*> patternptrs;
+
+	for (const auto& entry : patterns)
+	{
+		patternptrs.emplace_back(&entry.Pattern);
+	}
+
+	std::printf("\n%-30s %10s %10s\n", "All patterns", "ms", "GB/s");
+
+	double singlepass = 0;
+	double vectorscans = 0;
+
+	{
+		std::vector<void*> results;
+
+		auto seconds = singlepass = Measure(options.Repetitions, [&]()
+		{
+			results = HAP::Scanner::FindPatterns(start, size, patternptrs);
+		});
+
+		mismatch |= results != reference;
+		std::printf("%-30s %10.3f %10.2f\n", "single pass", seconds * 1000.0, GetThroughput(size, seconds));
+	}
+
+	{
+		std::vector<void*> results;
+
+		auto seconds = Measure(options.Repetitions, [&]()
+		{
+			results = HAP::Scanner::FindPatternsParallel(start, size, patternptrs);
+		});
+
+		mismatch |= results != reference;
+		std::printf("%-30s %10.3f %10.2f\n", "single pass, threaded", seconds * 1000.0, GetThroughput(size, seconds));
+	}
+
+	for (const auto& engine : Engines)
+	{
+		std::vector<void*> results(patterns.size());
+
+		auto seconds = Measure(options.Repetitions, [&]()
+		{
+			for (size_t i = 0; i < patterns.size(); i++)
+			{
+				results[i] = HAP::Scanner::FindPattern(start, size, patterns[i].Pattern, engine.Engine);
+			}
+		});
+
+		mismatch |= results != reference;
+
+		if (engine.Engine == HAP::PatternScanEngine::Vector)
+		{
+			vectorscans = seconds;
+		}
+
+		char name[64];
+		std::snprintf(name, sizeof(name), "one scan each, %s", engine.Name);
+
+		std::printf("%-30s %10.3f %10.2f\n", name, seconds * 1000.0, GetThroughput(size * patterns.size(), seconds));
+	}
+
+	/*
+		Startup resolves everything with the single pass, it has to stay ahead of
+		scanning for each pattern. Some slack is left for timing noise.
+	*/
+	std::printf("\nSingle pass is %.2fx the speed of one vector scan each\n", vectorscans / singlepass);
+
+	auto slower = singlepass > vectorscans * 1.1;
+
+	if (slower)
+	{
+		std::printf("Single pass is slower than one vector scan each\n");
+	}
+
+	/*
+		Runtime parsing, for comparison with the compile time patterns.
+	*/
+	{
+		const char* text = "55 8B EC 51 53 56 57 8B F1 6A 00 89 75 FC E8 ?? ?? ?? ?? 8B 7D 08 83 C4 04 8B CE FF 37 E8 ?? ?? ?? ?? 33 DB 39 9E ?? ?? ?? ?? 7E 41";
+
+		enum
+		{
+			ParseCount = 100000
+		};
+
+		size_t total = 0;
+
+		auto seconds = Measure(options.Repetitions, [&]()
+		{
+			for (int i = 0; i < ParseCount; i++)
+			{
+				total += HAP::GetPatternFromString(text).Length;
+			}
+		});
+
+		std::printf("\nGetPatternFromString: %.1f ns per pattern (%zu)\n", seconds * 1e9 / ParseCount, total);
+	}
+
+	if (mismatch)
+	{
+		std::printf("\nEngines disagree with the scalar reference\n");
+		return 1;
+	}
+
+	if (slower)
+	{
+		return 1;
+	}
+
+	return 0;
+}
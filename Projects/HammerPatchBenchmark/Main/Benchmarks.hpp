@@ -0,0 +1,7 @@
+#pragma once
+
+/*
+	Arguments are the ones following the benchmark name.
+*/
+int RunVertexBenchmark(int argc, char** argv);
+int RunFloatBenchmark(int argc, char** argv);
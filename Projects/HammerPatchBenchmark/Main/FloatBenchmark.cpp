@@ -0,0 +1,196 @@
+#include "Benchmarks.hpp"
+
+#include "Application/Text/FloatText.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <chrono>
+
+namespace
+{
+	struct Options
+	{
+		size_t Count = 1000000;
+		int Repetitions = 3;
+		uint32_t Seed = 1;
+	};
+
+	/*
+		Half on the grid, half moved off it the way vertex editing and
+		rotation leave them.
+	*/
+	std::vector<float> CreateValues(size_t count, std::mt19937& rng)
+	{
+		std::uniform_int_distribution<int32_t> grid(-1024, 1024);
+		std::uniform_real_distribution<float> offgrid(-16384.0f, 16384.0f);
+
+		std::vector<float> ret(count);
+
+		for (auto& value : ret)
+		{
+			if (rng() % 2 == 0)
+			{
+				value = float(grid(rng) * 8);
+			}
+
+			else
+			{
+				value = offgrid(rng);
+			}
+		}
+
+		return ret;
+	}
+
+	/*
+		Best of all repetitions, in seconds.
+	*/
+	template <typename Func>
+	double Measure(int repetitions, Func&& func)
+	{
+		double best = 1e30;
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			func();
+			auto end = std::chrono::high_resolution_clock::now();
+
+			auto seconds = std::chrono::duration<double>(end - start).count();
+
+			if (seconds < best)
+			{
+				best = seconds;
+			}
+		}
+
+		return best;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 0; i < argc; i++)
+		{
+			auto arg = argv[i];
+			auto hasvalue = i + 1 < argc;
+
+			if (std::strcmp(arg, "-count") == 0 && hasvalue)
+			{
+				options.Count = std::strtoul(argv[++i], nullptr, 10);
+			}
+
+			else if (std::strcmp(arg, "-reps") == 0 && hasvalue)
+			{
+				options.Repetitions = std::atoi(argv[++i]);
+			}
+
+			else if (std::strcmp(arg, "-seed") == 0 && hasvalue)
+			{
+				options.Seed = std::strtoul(argv[++i], nullptr, 10);
+			}
+
+			else
+			{
+				std::printf("Usage: floats [-count values] [-reps count] [-seed value]\n");
+				return false;
+			}
+		}
+
+		return options.Count > 0 && options.Repetitions >= 1;
+	}
+}
+
+/*
+	Formatting of the points in the vertex text file. Every value is
+	read back to see which formats keep the exact float.
+*/
+int RunFloatBenchmark(int argc, char** argv)
+{
+	Options options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	std::mt19937 rng(options.Seed);
+	auto values = CreateValues(options.Count, rng);
+
+	struct Format
+	{
+		const char* Name;
+		size_t(*Function)(float value, char* dest);
+	};
+
+	const Format formats[] =
+	{
+		{ "%g", [](float value, char* dest)
+		{
+			return static_cast<size_t>(std::snprintf(dest, 32, "%g", value));
+		}},
+
+		{ "%.9g", [](float value, char* dest)
+		{
+			return static_cast<size_t>(std::snprintf(dest, 32, "%.9g", value));
+		}},
+
+		{ "FloatText", HAP::FloatText::Format },
+	};
+
+	std::vector<char> output(values.size() * 32);
+
+	std::printf("%zu values, best of %d\n\n", values.size(), options.Repetitions);
+	std::printf("%-10s %10s %10s %12s %10s\n", "Format", "ms", "ns/value", "Bytes/value", "Inexact");
+
+	bool mismatch = false;
+
+	for (const auto& format : formats)
+	{
+		size_t size = 0;
+
+		auto seconds = Measure(options.Repetitions, [&]()
+		{
+			size = 0;
+
+			for (auto value : values)
+			{
+				size += format.Function(value, output.data() + size);
+				output[size++] = ' ';
+			}
+		});
+
+		size_t inexact = 0;
+		auto text = output.data();
+
+		for (auto value : values)
+		{
+			char* end;
+			auto back = std::strtof(text, &end);
+
+			inexact += std::memcmp(&back, &value, sizeof(value)) != 0;
+			text = end + 1;
+		}
+
+		/*
+			The whole point of the dedicated formatter.
+		*/
+		if (format.Function == HAP::FloatText::Format && inexact > 0)
+		{
+			mismatch = true;
+		}
+
+		std::printf("%-10s %10.3f %10.1f %12.2f %10zu\n", format.Name, seconds * 1e3, seconds * 1e9 / values.size(), double(size) / values.size(), inexact);
+	}
+
+	if (mismatch)
+	{
+		std::printf("\nFloatText did not give back the exact values\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,363 @@
+#include "Benchmarks.hpp"
+
+#include "Application/Modules/Save Load/VertexFile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+namespace
+{
+	struct Options
+	{
+		int Repetitions = 3;
+		uint32_t Seed = 1;
+	};
+
+	struct SyntheticMap
+	{
+		std::vector<uint8_t> Version1;
+		HAP::VertexFile::Writer Writer;
+
+		/*
+			Face IDs in the order Hammer asks for them.
+		*/
+		std::vector<int32_t> Lookups;
+	};
+
+	template <typename T>
+	void Append(std::vector<uint8_t>& data, const T& value)
+	{
+		auto bytes = reinterpret_cast<const uint8_t*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	/*
+		Boxes on the grid, a quarter of them with their corners moved off the grid
+		the way vertex editing leaves them. Every corner is shared by 3 faces.
+		IDs have gaps the way they do after editing a map for a while.
+	*/
+	SyntheticMap CreateMap(size_t facecount, std::mt19937& rng)
+	{
+		enum
+		{
+			FacesPerSolid = 6,
+			PointsPerFace = 4,
+		};
+
+		/*
+			Corner index bits are X, Y and Z.
+		*/
+		const int32_t facecorners[FacesPerSolid][PointsPerFace] =
+		{
+			{ 0, 2, 3, 1 },
+			{ 4, 5, 7, 6 },
+			{ 0, 1, 5, 4 },
+			{ 2, 6, 7, 3 },
+			{ 0, 4, 6, 2 },
+			{ 1, 3, 7, 5 },
+		};
+
+		SyntheticMap ret;
+
+		auto solidcount = static_cast<int32_t>((facecount + FacesPerSolid - 1) / FacesPerSolid);
+
+		Append<int32_t>(ret.Version1, 1);
+		Append<int32_t>(ret.Version1, solidcount);
+
+		std::uniform_int_distribution<int32_t> gap(1, 3);
+		std::uniform_int_distribution<int32_t> origin(-512, 511);
+		std::uniform_int_distribution<int32_t> extent(1, 64);
+		std::uniform_real_distribution<float> offgrid(-4.0f, 4.0f);
+
+		int32_t nextid = 1;
+
+		for (int32_t i = 0; i < solidcount; i++)
+		{
+			HAP::Vector3 corners[8];
+
+			float start[3];
+			float size[3];
+
+			for (size_t j = 0; j < 3; j++)
+			{
+				start[j] = float(origin(rng) * 16);
+				size[j] = float(extent(rng) * 8);
+			}
+
+			auto isedited = rng() % 4 == 0;
+
+			for (int32_t j = 0; j < 8; j++)
+			{
+				auto& corner = corners[j];
+				corner.X = start[0] + (j & 1 ? size[0] : 0);
+				corner.Y = start[1] + (j & 2 ? size[1] : 0);
+				corner.Z = start[2] + (j & 4 ? size[2] : 0);
+
+				if (isedited)
+				{
+					corner.X += offgrid(rng);
+					corner.Y += offgrid(rng);
+					corner.Z += offgrid(rng);
+				}
+			}
+
+			Append<int32_t>(ret.Version1, nextid);
+			Append<int32_t>(ret.Version1, FacesPerSolid);
+
+			ret.Writer.AddSolid(nextid);
+			nextid += gap(rng);
+
+			for (const auto& face : facecorners)
+			{
+				Append<int32_t>(ret.Version1, nextid);
+				Append<int32_t>(ret.Version1, PointsPerFace);
+
+				HAP::Vector3 points[PointsPerFace];
+
+				for (int32_t k = 0; k < PointsPerFace; k++)
+				{
+					points[k] = corners[face[k]];
+					Append(ret.Version1, points[k]);
+				}
+
+				ret.Writer.AddFace(nextid, points, PointsPerFace);
+
+				ret.Lookups.emplace_back(nextid);
+				nextid += gap(rng);
+			}
+		}
+
+		std::shuffle(ret.Lookups.begin(), ret.Lookups.end(), rng);
+
+		return ret;
+	}
+
+	/*
+		Best of all repetitions, in seconds.
+	*/
+	template <typename Func>
+	double Measure(int repetitions, Func&& func)
+	{
+		double best = 1e30;
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			func();
+			auto end = std::chrono::high_resolution_clock::now();
+
+			auto seconds = std::chrono::duration<double>(end - start).count();
+
+			if (seconds < best)
+			{
+				best = seconds;
+			}
+		}
+
+		return best;
+	}
+
+	/*
+		How faces used to be found, every solid and face from the start.
+	*/
+	const HAP::VertexFile::Face* FindFaceLinear(const HAP::VertexFile::MappedVertexFile& file, int32_t id)
+	{
+		for (const auto& face : file.GetFaces())
+		{
+			if (face.ID == id)
+			{
+				return &face;
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 0; i < argc; i++)
+		{
+			auto arg = argv[i];
+			auto hasvalue = i + 1 < argc;
+
+			if (std::strcmp(arg, "-reps") == 0 && hasvalue)
+			{
+				options.Repetitions = std::atoi(argv[++i]);
+			}
+
+			else if (std::strcmp(arg, "-seed") == 0 && hasvalue)
+			{
+				options.Seed = std::strtoul(argv[++i], nullptr, 10);
+			}
+
+			else
+			{
+				std::printf("Usage: vertices [-reps count] [-seed value]\n");
+				return false;
+			}
+		}
+
+		return options.Repetitions >= 1;
+	}
+}
+
+/*
+	Opening a map parses the vertex file, then restores every face by ID.
+	Time per face should stay flat as maps get bigger. Every file format
+	is checked against the first one.
+*/
+int RunVertexBenchmark(int argc, char** argv)
+{
+	Options options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	enum
+	{
+		/*
+			The linear lookup is quadratic, larger maps take too long to show.
+		*/
+		MaxLinearFaces = 60000
+	};
+
+	const size_t facecounts[] =
+	{
+		12500, 25000, 50000, 100000, 200000, 400000, 800000
+	};
+
+	std::mt19937 rng(options.Seed);
+	bool mismatch = false;
+
+	std::printf("%9s %-11s %9s %10s %10s %10s %14s %14s %15s\n", "Faces", "Format", "Size MB", "Write ms", "Parse ms", "Lookup ms", "Parse ns/face", "Total ns/face", "Linear ns/face");
+
+	for (auto facecount : facecounts)
+	{
+		auto map = CreateMap(facecount, rng);
+		auto count = map.Lookups.size();
+
+		struct Format
+		{
+			const char* Name;
+			std::vector<uint8_t> Data;
+			double Write;
+		};
+
+		Format formats[] =
+		{
+			{ "v1", std::move(map.Version1), 0 },
+			{ "v2 raw", {}, 0 },
+			{ "v2 packed", {}, 0 },
+		};
+
+		HAP::ArenaBuffer output;
+
+		formats[1].Write = Measure(options.Repetitions, [&]()
+		{
+			map.Writer.Serialize(output, HAP::VertexFile::SectionEncoding::Raw);
+		});
+
+		output.CopyTo(formats[1].Data);
+
+		formats[2].Write = Measure(options.Repetitions, [&]()
+		{
+			map.Writer.Serialize(output, HAP::VertexFile::SectionEncoding::Compressed);
+		});
+
+		output.CopyTo(formats[2].Data);
+
+		for (const auto& format : formats)
+		{
+			HAP::VertexFile::MappedVertexFile file;
+
+			auto parse = Measure(options.Repetitions, [&]()
+			{
+				if (file.Parse(format.Data.data(), format.Data.size()) != HAP::VertexFile::LoadStatus::Success)
+				{
+					mismatch = true;
+				}
+			});
+
+			size_t found = 0;
+
+			auto lookup = Measure(options.Repetitions, [&]()
+			{
+				found = 0;
+
+				for (auto id : map.Lookups)
+				{
+					auto face = file.FindFace(id);
+					found += face && face->ID == id;
+				}
+			});
+
+			if (found != count)
+			{
+				std::printf("Only found %zu of %zu faces\n", found, count);
+				mismatch = true;
+			}
+
+			/*
+				Every format has to give back the same points.
+			*/
+			const auto& reference = formats[0].Data;
+			mismatch |= file.GetFaces().size() != count;
+
+			if (&format != &formats[0])
+			{
+				HAP::VertexFile::MappedVertexFile original;
+				original.Parse(reference.data(), reference.size());
+
+				for (size_t i = 0; i < count && !mismatch; i++)
+				{
+					const auto& left = original.GetFaces()[i];
+					const auto& right = file.GetFaces()[i];
+
+					mismatch |= left.ID != right.ID || left.PointCount != right.PointCount;
+					mismatch |= !mismatch && std::memcmp(left.Points, right.Points, left.PointCount * sizeof(HAP::Vector3)) != 0;
+				}
+			}
+
+			char write[32] = "-";
+			char linear[32] = "-";
+
+			if (format.Write > 0)
+			{
+				std::snprintf(write, sizeof(write), "%.3f", format.Write * 1e3);
+			}
+
+			if (count <= MaxLinearFaces && &format == &formats[0])
+			{
+				auto seconds = Measure(1, [&]()
+				{
+					for (auto id : map.Lookups)
+					{
+						mismatch |= FindFaceLinear(file, id) != file.FindFace(id);
+					}
+				});
+
+				std::snprintf(linear, sizeof(linear), "%.1f", seconds * 1e9 / count);
+			}
+
+			auto megabytes = format.Data.size() / (1024.0 * 1024.0);
+
+			std::printf("%9zu %-11s %9.2f %10s %10.3f %10.3f %14.1f %14.1f %15s\n", count, format.Name, megabytes, write, parse * 1e3, lookup * 1e3, parse * 1e9 / count, (parse + lookup) * 1e9 / count, linear);
+		}
+	}
+
+	if (mismatch)
+	{
+		std::printf("\nFace lookups gave wrong results\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -7,6 +7,7 @@
 
 #include <thread>
 #include <chrono>
+#include <string>
 
 using namespace std::literals;
 
@@ -89,7 +90,56 @@ namespace
 		uint8_t* Address;
 	};
 
-	PROCESS_INFORMATION StartProcess(const wchar_t* path)
+	/*
+		Quotes "argument" so that CommandLineToArgvW and the CRT read back the same string.
+		Backslashes are only special in front of a quote, so those are doubled.
+	*/
+	void AppendArgument(std::wstring& output, const wchar_t* argument)
+	{
+		if (*argument != 0 && wcspbrk(argument, L" \t\n\v\"") == nullptr)
+		{
+			output += argument;
+			return;
+		}
+
+		output += L'"';
+
+		for (auto it = argument; ; ++it)
+		{
+			size_t backslashes = 0;
+
+			while (*it == L'\\')
+			{
+				++it;
+				++backslashes;
+			}
+
+			if (*it == 0)
+			{
+				output.append(backslashes * 2, L'\\');
+				break;
+			}
+
+			if (*it == L'"')
+			{
+				output.append(backslashes * 2 + 1, L'\\');
+			}
+
+			else
+			{
+				output.append(backslashes, L'\\');
+			}
+
+			output += *it;
+		}
+
+		output += L'"';
+	}
+
+	/*
+		"extraargs" is added to the end of Hammer's command line.
+	*/
+	PROCESS_INFORMATION StartProcess(const wchar_t* path, const std::wstring& extraargs)
 	{
 		/*
 			Always make the process' working directory
@@ -100,9 +150,11 @@ namespace
 
 		RemoveFileName(rundir);
 
-		wchar_t args[1024];
-		wcscpy_s(args, path);
-		wcscat_s(args, L" -nop4");
+		std::wstring args;
+		AppendArgument(args, path);
+
+		args += L" -nop4";
+		args += extraargs;
 
 		STARTUPINFOW startinfo = {};
 		startinfo.cb = sizeof(startinfo);
@@ -114,7 +166,7 @@ namespace
 			CreateProcessW
 			(
 				path,
-				args,
+				&args[0],
 				nullptr,
 				nullptr,
 				false,
@@ -201,9 +253,22 @@ void wmain(int argc, wchar_t* argv[])
 	GetCurrentDirectoryW(sizeof(hammerexe), hammerexe);
 	wcscat_s(hammerexe, L"\\hammer.exe");
 
+	/*
+		Anything given to the launcher is passed on to Hammer,
+		HammerPatch reads its own switches from there. The CRT
+		has already unquoted these, so they are quoted again.
+	*/
+	std::wstring extraargs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		extraargs += L' ';
+		AppendArgument(extraargs, argv[i]);
+	}
+
 	try
 	{
-		auto info = StartProcess(hammerexe);
+		auto info = StartProcess(hammerexe, extraargs);
 
 		ScopedHandle process(info.hProcess);
 		ScopedHandle thread(info.hThread);
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace Tools
+{
+	/*
+		Each command gets the arguments following its name and
+		returns the process exit code.
+	*/
+	int Verify(int argc, char** argv);
+	int Generate(int argc, char** argv);
+}
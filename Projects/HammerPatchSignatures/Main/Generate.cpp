@@ -0,0 +1,409 @@
+#include "Commands.hpp"
+#include "SuffixArray.hpp"
+
+#include "Application/PE/PortableExecutable.hpp"
+#include "Application/Files/MappedFile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	enum
+	{
+		MaxSignatureLength = 256,
+	};
+
+	struct Target
+	{
+		std::string Name;
+		uint32_t RVA;
+	};
+
+	/*
+		Executable sections copied back to back so one index covers them all.
+	*/
+	struct CodeImage
+	{
+		struct Span
+		{
+			size_t Start;
+			size_t FileOffset;
+			size_t Length;
+		};
+
+		std::vector<uint8_t> Bytes;
+		std::vector<Span> Spans;
+
+		/*
+			Bytes rewritten by the loader, these can never be part of a signature.
+		*/
+		std::vector<uint8_t> Relocated;
+
+		bool FromFileOffset(size_t offset, size_t& index, size_t& spanend) const
+		{
+			for (const auto& span : Spans)
+			{
+				if (offset >= span.FileOffset && offset - span.FileOffset < span.Length)
+				{
+					index = span.Start + (offset - span.FileOffset);
+					spanend = span.Start + span.Length;
+					return true;
+				}
+			}
+
+			return false;
+		}
+	};
+
+	struct Signature
+	{
+		std::vector<uint8_t> Values;
+		std::vector<uint8_t> Known;
+	};
+
+	bool ParseTarget(const char* text, Target& target)
+	{
+		auto separator = std::strchr(text, '=');
+		auto number = text;
+
+		if (separator)
+		{
+			target.Name.assign(text, separator);
+			number = separator + 1;
+		}
+
+		char* end;
+		auto value = std::strtoul(number, &end, 16);
+
+		if (end == number || *end != 0)
+		{
+			return false;
+		}
+
+		target.RVA = static_cast<uint32_t>(value);
+
+		if (target.Name.empty())
+		{
+			char name[32];
+			std::snprintf(name, sizeof(name), "Function_%08X", target.RVA);
+
+			target.Name = name;
+		}
+
+		return true;
+	}
+
+	/*
+		Call, jump and conditional jump displacements change whenever code
+		moves around between builds. Without decoding instructions an E8 or
+		E9 byte may also be an operand, which only costs extra wildcards.
+	*/
+	void MaskRelativeBranches(const uint8_t* data, std::vector<uint8_t>& known)
+	{
+		auto length = known.size();
+
+		for (size_t i = 0; i < length;)
+		{
+			size_t operand = 0;
+
+			if (data[i] == 0xE8 || data[i] == 0xE9)
+			{
+				operand = i + 1;
+			}
+
+			else if (data[i] == 0x0F && i + 1 < length && (data[i + 1] & 0xF0) == 0x80)
+			{
+				operand = i + 2;
+			}
+
+			if (operand == 0)
+			{
+				i++;
+				continue;
+			}
+
+			for (size_t j = operand; j < operand + 4 && j < length; j++)
+			{
+				known[j] = 0;
+			}
+
+			i = operand + 4;
+		}
+	}
+
+	/*
+		Number of places the first "length" bytes of the signature match,
+		counting stops at 2. The longest run of known bytes is looked up in
+		the index and only those candidates are compared in full.
+	*/
+	size_t CountMatches(const CodeImage& code, const Tools::SuffixArray& index, const Signature& signature, size_t length)
+	{
+		size_t runstart = 0;
+		size_t runlength = 0;
+
+		for (size_t i = 0; i < length;)
+		{
+			if (!signature.Known[i])
+			{
+				i++;
+				continue;
+			}
+
+			auto start = i;
+
+			while (i < length && signature.Known[i])
+			{
+				i++;
+			}
+
+			if (i - start > runlength)
+			{
+				runstart = start;
+				runlength = i - start;
+			}
+		}
+
+		if (runlength == 0)
+		{
+			return 2;
+		}
+
+		size_t first;
+		size_t last;
+		index.FindRange(signature.Values.data() + runstart, runlength, first, last);
+
+		size_t ret = 0;
+
+		for (auto i = first; i < last && ret < 2; i++)
+		{
+			auto position = index[i];
+
+			if (position < runstart || position - runstart + length > code.Bytes.size())
+			{
+				continue;
+			}
+
+			auto start = code.Bytes.data() + position - runstart;
+			bool match = true;
+
+			for (size_t j = 0; j < length; j++)
+			{
+				if (signature.Known[j] && start[j] != signature.Values[j])
+				{
+					match = false;
+					break;
+				}
+			}
+
+			if (match)
+			{
+				ret++;
+			}
+		}
+
+		return ret;
+	}
+
+	/*
+		Grows the signature one byte at a time from the function start until
+		it only matches there. Adding a byte never adds matches, so the first
+		unique length is the shortest one.
+	*/
+	bool GenerateSignature(const CodeImage& code, const Tools::SuffixArray& index, size_t start, size_t spanend, Signature& signature)
+	{
+		auto maxlength = std::min<size_t>(MaxSignatureLength, spanend - start);
+
+		signature.Values.assign(code.Bytes.begin() + start, code.Bytes.begin() + start + maxlength);
+		signature.Known.resize(maxlength);
+
+		for (size_t i = 0; i < maxlength; i++)
+		{
+			signature.Known[i] = !code.Relocated[start + i];
+		}
+
+		MaskRelativeBranches(signature.Values.data(), signature.Known);
+
+		for (size_t length = 1; length <= maxlength; length++)
+		{
+			/*
+				A trailing wildcard cannot make it more unique.
+			*/
+			if (!signature.Known[length - 1])
+			{
+				continue;
+			}
+
+			if (CountMatches(code, index, signature, length) == 1)
+			{
+				signature.Values.resize(length);
+				signature.Known.resize(length);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	std::string FormatSignature(const Signature& signature)
+	{
+		std::string ret;
+
+		for (size_t i = 0; i < signature.Values.size(); i++)
+		{
+			char text[4];
+
+			if (signature.Known[i])
+			{
+				std::snprintf(text, sizeof(text), "%02X", signature.Values[i]);
+			}
+
+			else
+			{
+				std::snprintf(text, sizeof(text), "??");
+			}
+
+			if (i != 0)
+			{
+				ret += ' ';
+			}
+
+			ret += text;
+		}
+
+		return ret;
+	}
+}
+
+namespace Tools
+{
+	/*
+		Creates the shortest signature that uniquely finds each given function
+		in a build, printed in the form used by the signature headers.
+	*/
+	int Generate(int argc, char** argv)
+	{
+		const char* game = "New";
+		const char* library = nullptr;
+		std::vector<Target> targets;
+
+		for (int i = 0; i < argc; i++)
+		{
+			if (std::strcmp(argv[i], "-game") == 0 && i + 1 < argc)
+			{
+				game = argv[++i];
+				continue;
+			}
+
+			if (!library)
+			{
+				library = argv[i];
+				continue;
+			}
+
+			Target target;
+
+			if (!ParseTarget(argv[i], target))
+			{
+				std::printf("Invalid target \"%s\", expected [name=]rva in hex\n", argv[i]);
+				return 2;
+			}
+
+			targets.emplace_back(target);
+		}
+
+		if (!library || targets.empty())
+		{
+			std::printf("Expected a library and at least one function\n");
+			return 2;
+		}
+
+		auto path = fs::u8path(library);
+
+		HAP::MappedFile file;
+		HAP::PE::ImageHeaders headers;
+
+		if (!file.Open(path) || !HAP::PE::ReadHeaders(file.GetData(), file.GetSize(), headers))
+		{
+			std::printf("Could not read PE image \"%s\"\n", library);
+			return 1;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		CodeImage code;
+
+		for (const auto& range : HAP::PE::GetCodeRanges(headers, HAP::PE::ImageLayout::File, file.GetSize()))
+		{
+			code.Spans.push_back({ code.Bytes.size(), range.Offset, range.Length });
+
+			auto data = file.GetData() + range.Offset;
+			code.Bytes.insert(code.Bytes.end(), data, data + range.Length);
+		}
+
+		code.Relocated.resize(code.Bytes.size());
+
+		for (const auto& relocation : HAP::PE::ReadRelocations(file.GetData(), file.GetSize(), headers, HAP::PE::ImageLayout::File))
+		{
+			for (uint32_t i = 0; i < relocation.Size; i++)
+			{
+				size_t offset;
+				size_t index;
+				size_t spanend;
+
+				if (HAP::PE::RVAToFileOffset(headers, relocation.RVA + i, offset) && code.FromFileOffset(offset, index, spanend))
+				{
+					code.Relocated[index] = 1;
+				}
+			}
+		}
+
+		SuffixArray index;
+		index.Build(code.Bytes.data(), code.Bytes.size());
+
+		auto end = std::chrono::high_resolution_clock::now();
+		auto seconds = std::chrono::duration<double>(end - start).count();
+
+		std::printf("/*\n\tIndexed %.1f MB of code from %s in %.2f s\n*/\n\n", code.Bytes.size() / (1024.0 * 1024.0), path.filename().u8string().c_str(), seconds);
+
+		int ret = 0;
+
+		for (const auto& target : targets)
+		{
+			size_t offset;
+			size_t position;
+			size_t spanend;
+
+			if (!HAP::PE::RVAToFileOffset(headers, target.RVA, offset) || !code.FromFileOffset(offset, position, spanend))
+			{
+				std::printf("/* %s: 0x%08X is not in a code section */\n\n", target.Name.c_str(), target.RVA);
+				ret = 1;
+				continue;
+			}
+
+			Signature signature;
+
+			if (!GenerateSignature(code, index, position, spanend, signature))
+			{
+				std::printf("/* %s: no unique signature within %d bytes */\n\n", target.Name.c_str(), MaxSignatureLength);
+				ret = 1;
+				continue;
+			}
+
+			std::printf("namespace %s\n{\n", target.Name.c_str());
+			std::printf("\t/*\n\t\t0x%08llX static %s Hammer address, build 0x%08X\n\t*/\n", static_cast<unsigned long long>(headers.ImageBase + target.RVA), game, headers.TimeDateStamp);
+			std::printf("\tconstexpr auto Pattern%s = HAP::CompilePattern(\"%s\");\n", game, FormatSignature(signature).c_str());
+			std::printf("}\n\n");
+		}
+
+		return ret;
+	}
+}
@@ -0,0 +1,47 @@
+#include "Commands.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	struct CommandInfo
+	{
+		const char* Name;
+		const char* Arguments;
+		int(*Function)(int argc, char** argv);
+	};
+
+	const CommandInfo Commands[] =
+	{
+		{ "verify", "[-threads count] <dll or directory>...", Tools::Verify },
+		{ "generate", "[-game name] <dll> <[name=]rva>...", Tools::Generate },
+	};
+
+	void PrintUsage(const char* program)
+	{
+		std::printf("Usage:\n");
+
+		for (const auto& command : Commands)
+		{
+			std::printf("  %s %s %s\n", program, command.Name, command.Arguments);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2)
+	{
+		for (const auto& command : Commands)
+		{
+			if (std::strcmp(argv[1], command.Name) == 0)
+			{
+				return command.Function(argc - 2, argv + 2);
+			}
+		}
+	}
+
+	PrintUsage(argv[0]);
+	return 2;
+}
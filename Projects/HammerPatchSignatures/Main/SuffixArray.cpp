@@ -0,0 +1,152 @@
+#include "SuffixArray.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace Tools
+{
+	/*
+		Prefix doubling with counting sorts, O(n log n) and independent of
+		how repetitive the data is. Code sections have long runs of padding
+		that make comparison sorts degrade badly.
+	*/
+	void SuffixArray::Build(const uint8_t* data, size_t size)
+	{
+		Data = data;
+		Size = size;
+
+		Suffixes.resize(size);
+
+		if (size == 0)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> rank(size);
+		std::vector<uint32_t> order(size);
+		std::vector<uint32_t> counts(std::max<size_t>(size, 256) + 1);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			counts[data[i]]++;
+		}
+
+		for (size_t i = 1; i < 256; i++)
+		{
+			counts[i] += counts[i - 1];
+		}
+
+		for (size_t i = size; i-- > 0;)
+		{
+			Suffixes[--counts[data[i]]] = static_cast<uint32_t>(i);
+		}
+
+		rank[Suffixes[0]] = 0;
+
+		for (size_t i = 1; i < size; i++)
+		{
+			auto prev = Suffixes[i - 1];
+			auto cur = Suffixes[i];
+
+			rank[cur] = rank[prev] + (data[cur] != data[prev]);
+		}
+
+		for (size_t step = 1; rank[Suffixes[size - 1]] + 1 < size; step *= 2)
+		{
+			/*
+				Order by the second half first: suffixes too short to have one
+				come first, then the rest follow the current order.
+			*/
+			size_t index = 0;
+
+			for (size_t i = size - step; i < size; i++)
+			{
+				order[index++] = static_cast<uint32_t>(i);
+			}
+
+			for (size_t i = 0; i < size; i++)
+			{
+				if (Suffixes[i] >= step)
+				{
+					order[index++] = static_cast<uint32_t>(Suffixes[i] - step);
+				}
+			}
+
+			/*
+				Then a stable sort on the first half.
+			*/
+			auto maxrank = rank[Suffixes[size - 1]];
+
+			std::fill(counts.begin(), counts.begin() + maxrank + 1, 0);
+
+			for (size_t i = 0; i < size; i++)
+			{
+				counts[rank[i]]++;
+			}
+
+			for (size_t i = 1; i <= maxrank; i++)
+			{
+				counts[i] += counts[i - 1];
+			}
+
+			for (size_t i = size; i-- > 0;)
+			{
+				Suffixes[--counts[rank[order[i]]]] = order[i];
+			}
+
+			auto secondrank = [&](uint32_t position)
+			{
+				return position + step < size ? int64_t(rank[position + step]) : -1;
+			};
+
+			order[Suffixes[0]] = 0;
+
+			for (size_t i = 1; i < size; i++)
+			{
+				auto prev = Suffixes[i - 1];
+				auto cur = Suffixes[i];
+
+				auto same = rank[cur] == rank[prev] && secondrank(cur) == secondrank(prev);
+
+				order[cur] = order[prev] + !same;
+			}
+
+			rank.swap(order);
+		}
+	}
+
+	int SuffixArray::Compare(uint32_t position, const uint8_t* needle, size_t length) const
+	{
+		auto available = Size - position;
+		auto res = std::memcmp(Data + position, needle, std::min(available, length));
+
+		if (res != 0)
+		{
+			return res;
+		}
+
+		/*
+			A suffix shorter than the needle sorts before it.
+		*/
+		return available < length ? -1 : 0;
+	}
+
+	void SuffixArray::FindRange(const uint8_t* needle, size_t length, size_t& first, size_t& last) const
+	{
+		auto begin = Suffixes.begin();
+		auto end = Suffixes.end();
+
+		auto lower = std::partition_point(begin, end, [&](uint32_t position)
+		{
+			return Compare(position, needle, length) < 0;
+		});
+
+		auto upper = std::partition_point(lower, end, [&](uint32_t position)
+		{
+			return Compare(position, needle, length) == 0;
+		});
+
+		first = lower - begin;
+		last = upper - begin;
+	}
+}
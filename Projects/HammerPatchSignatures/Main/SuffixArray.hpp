@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tools
+{
+	/*
+		All suffixes of a block of bytes in sorted order. Built once per image,
+		after which any byte string is located with a binary search.
+	*/
+	class SuffixArray
+	{
+	public:
+		void Build(const uint8_t* data, size_t size);
+
+		/*
+			Range of entries in the array whose suffixes start with "needle".
+		*/
+		void FindRange(const uint8_t* needle, size_t length, size_t& first, size_t& last) const;
+
+		uint32_t operator[](size_t index) const
+		{
+			return Suffixes[index];
+		}
+
+	private:
+		int Compare(uint32_t position, const uint8_t* needle, size_t length) const;
+
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+
+		std::vector<uint32_t> Suffixes;
+	};
+}
@@ -0,0 +1,303 @@
+#include "Commands.hpp"
+
+#include "Application/Scanner/PatternScanner.hpp"
+#include "Application/PE/PortableExecutable.hpp"
+#include "Application/Files/MappedFile.hpp"
+#include "Application/Modules/Save Load/SaveLoadSignatures.hpp"
+#include "Application/Threading/RunChunks.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	struct PatternResult
+	{
+		/*
+			Counting stops at 2, that is enough to call it ambiguous.
+		*/
+		size_t Matches = 0;
+		uint32_t RVA = 0;
+
+		/*
+			Values of the pattern's captures at the first match.
+		*/
+		std::vector<int32_t> Captures;
+	};
+
+	struct Build
+	{
+		fs::path Path;
+
+		HAP::MappedFile File;
+		HAP::PE::ImageHeaders Headers;
+		std::vector<HAP::PE::ImageRange> CodeRanges;
+
+		bool Valid = false;
+
+		std::vector<PatternResult> Results;
+	};
+
+	bool IsLibrary(const fs::path& path)
+	{
+		auto extension = path.extension().string();
+
+		for (auto& c : extension)
+		{
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		}
+
+		return extension == ".dll";
+	}
+
+	void AddPath(const fs::path& path, std::vector<fs::path>& files)
+	{
+		std::error_code error;
+
+		if (fs::is_directory(path, error))
+		{
+			for (fs::recursive_directory_iterator it(path, error), end; it != end; it.increment(error))
+			{
+				if (it->is_regular_file(error) && IsLibrary(it->path()))
+				{
+					files.emplace_back(it->path());
+				}
+			}
+		}
+
+		else
+		{
+			files.emplace_back(path);
+		}
+	}
+
+	PatternResult CountMatches(const Build& build, const HAP::BytePattern& pattern)
+	{
+		PatternResult ret;
+
+		auto base = const_cast<uint8_t*>(build.File.GetData());
+
+		for (const auto& range : build.CodeRanges)
+		{
+			auto start = base + range.Offset;
+			auto end = start + range.Length;
+
+			while (ret.Matches < 2 && start < end)
+			{
+				auto address = static_cast<uint8_t*>(HAP::Scanner::FindPattern(start, end - start, pattern));
+
+				if (!address)
+				{
+					break;
+				}
+
+				if (ret.Matches == 0)
+				{
+					HAP::PE::FileOffsetToRVA(build.Headers, address - base, ret.RVA);
+
+					for (size_t i = 0; i < pattern.CaptureCount; i++)
+					{
+						ret.Captures.emplace_back(HAP::ReadCapture(address, pattern.Captures[i]));
+					}
+				}
+
+				ret.Matches++;
+				start = address + 1;
+			}
+		}
+
+		return ret;
+	}
+
+	/*
+		Every build has to resolve each hooked function through exactly one
+		of its patterns, and no pattern may hit more than one place.
+	*/
+	bool IsBuildUsable(const Build& build, const std::vector<HAP::NamedPattern>& patterns)
+	{
+		if (!build.Valid)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < patterns.size(); i++)
+		{
+			if (build.Results[i].Matches > 1)
+			{
+				return false;
+			}
+
+			size_t unique = 0;
+
+			for (size_t j = 0; j < patterns.size(); j++)
+			{
+				if (std::strcmp(patterns[i].Name, patterns[j].Name) == 0 && build.Results[j].Matches == 1)
+				{
+					unique++;
+				}
+			}
+
+			if (unique != 1)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void PrintBuild(const Build& build, const std::vector<HAP::NamedPattern>& patterns)
+	{
+		std::printf("%s\n", build.Path.u8string().c_str());
+
+		if (!build.Valid)
+		{
+			std::printf("  Could not read PE image\n\n");
+			return;
+		}
+
+		std::printf("  Timestamp 0x%08X, %zu code sections\n", build.Headers.TimeDateStamp, build.CodeRanges.size());
+
+		for (size_t i = 0; i < patterns.size(); i++)
+		{
+			const auto& entry = patterns[i];
+			const auto& result = build.Results[i];
+
+			if (result.Matches == 0)
+			{
+				std::printf("  %-30s %-5s none\n", entry.Name, entry.Game);
+			}
+
+			else if (result.Matches == 1)
+			{
+				std::printf("  %-30s %-5s unique     0x%08X", entry.Name, entry.Game, result.RVA);
+
+				for (size_t j = 0; j < entry.Pattern.CaptureCount; j++)
+				{
+					std::printf(" %s=%d", entry.Pattern.Captures[j].Name, result.Captures[j]);
+				}
+
+				std::printf("\n");
+			}
+
+			else
+			{
+				std::printf("  %-30s %-5s ambiguous  0x%08X\n", entry.Name, entry.Game, result.RVA);
+			}
+		}
+
+		std::printf("  %s\n\n", IsBuildUsable(build, patterns) ? "OK" : "FAILED");
+	}
+}
+
+namespace Tools
+{
+	/*
+		Runs every shipped signature against a set of Hammer builds on disk
+		and reports which of them still resolve to exactly one function.
+	*/
+	int Verify(int argc, char** argv)
+	{
+		size_t threadcount = HAP::GetWorkerCount();
+		std::vector<fs::path> files;
+
+		for (int i = 0; i < argc; i++)
+		{
+			if (std::strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			{
+				threadcount = std::strtoul(argv[++i], nullptr, 10);
+				continue;
+			}
+
+			AddPath(fs::u8path(argv[i]), files);
+		}
+
+		if (files.empty())
+		{
+			std::printf("No libraries given\n");
+			return 2;
+		}
+
+		std::sort(files.begin(), files.end());
+
+		auto patterns = HAP::SaveLoadSignatures::GetAll();
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		std::vector<std::unique_ptr<Build>> builds;
+		size_t totalbytes = 0;
+
+		for (const auto& path : files)
+		{
+			auto build = std::make_unique<Build>();
+			build->Path = path;
+			build->Results.resize(patterns.size());
+
+			if (build->File.Open(path))
+			{
+				auto data = build->File.GetData();
+				auto size = build->File.GetSize();
+
+				if (HAP::PE::ReadHeaders(data, size, build->Headers))
+				{
+					build->CodeRanges = HAP::PE::GetCodeRanges(build->Headers, HAP::PE::ImageLayout::File, size);
+					build->Valid = true;
+
+					for (const auto& range : build->CodeRanges)
+					{
+						totalbytes += range.Length;
+					}
+				}
+			}
+
+			builds.emplace_back(std::move(build));
+		}
+
+		/*
+			One job per build and pattern so a few large builds still
+			spread over all cores.
+		*/
+		auto jobcount = builds.size() * patterns.size();
+		threadcount = std::max<size_t>(1, std::min(threadcount, jobcount));
+
+		HAP::RunChunks(jobcount, threadcount, [&](size_t job)
+		{
+			auto& build = *builds[job / patterns.size()];
+			auto index = job % patterns.size();
+
+			if (build.Valid)
+			{
+				build.Results[index] = CountMatches(build, patterns[index].Pattern);
+			}
+		});
+
+		auto end = std::chrono::high_resolution_clock::now();
+		auto seconds = std::chrono::duration<double>(end - start).count();
+
+		size_t usable = 0;
+
+		for (const auto& build : builds)
+		{
+			PrintBuild(*build, patterns);
+
+			if (IsBuildUsable(*build, patterns))
+			{
+				usable++;
+			}
+		}
+
+		std::printf("%zu of %zu builds resolve every hook, scanned %.1f MB of code in %.2f s on %zu threads\n", usable, builds.size(), totalbytes / (1024.0 * 1024.0), seconds, threadcount);
+
+		return usable == builds.size() ? 0 : 1;
+	}
+}
@@ -0,0 +1,90 @@
+#include "Commands.hpp"
+
+#include "Application/Files/MappedFile.hpp"
+#include "Application/Modules/Save Load/VertexFile.hpp"
+#include "Application/Modules/Save Load/VertexText.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+namespace
+{
+	namespace fs = std::filesystem;
+}
+
+namespace Tools
+{
+	/*
+		Turns .hpvertstext back into a vertex file, such as when only the text of a map is left.
+	*/
+	int Binary(int argc, char** argv)
+	{
+		auto encoding = HAP::VertexFile::SectionEncoding::Raw;
+
+		if (argc >= 1 && std::strcmp(argv[0], "-compress") == 0)
+		{
+			encoding = HAP::VertexFile::SectionEncoding::Compressed;
+
+			argc--;
+			argv++;
+		}
+
+		if (argc < 1 || argc > 2)
+		{
+			std::printf("Expected a vertex text file and optionally where to write the vertex file\n");
+			return 2;
+		}
+
+		auto input = fs::u8path(argv[0]);
+		auto output = input;
+
+		if (argc == 2)
+		{
+			output = fs::u8path(argv[1]);
+		}
+
+		else
+		{
+			output.replace_extension(".hpverts");
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		HAP::MappedFile file;
+
+		if (!file.Open(input))
+		{
+			std::printf("Could not open \"%s\"\n", argv[0]);
+			return 1;
+		}
+
+		HAP::VertexFile::Writer writer;
+		size_t errorline = 0;
+
+		auto text = reinterpret_cast<const char*>(file.GetData());
+		auto res = HAP::VertexFile::Text::Parse(text, file.GetSize(), writer, errorline);
+
+		if (res != HAP::VertexFile::Text::ParseStatus::Success)
+		{
+			std::printf("Could not read \"%s\" at line %zu: %s\n", argv[0], errorline, HAP::VertexFile::Text::ParseStatusToString(res));
+			return 1;
+		}
+
+		HAP::ArenaBuffer binary;
+		writer.Serialize(binary, encoding);
+
+		if (!WriteFile(output, binary))
+		{
+			std::printf("Could not write \"%s\"\n", output.string().c_str());
+			return 1;
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		auto seconds = std::chrono::duration<double>(end - start).count();
+
+		std::printf("Wrote %zu solids, %zu faces and %zu points to \"%s\" in %.1f ms\n", writer.GetSolidCount(), writer.GetFaceCount(), writer.GetPointCount(), output.string().c_str(), seconds * 1e3);
+
+		return 0;
+	}
+}
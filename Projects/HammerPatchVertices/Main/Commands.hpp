@@ -0,0 +1,19 @@
+#pragma once
+#include "Application/Memory/ArenaBuffer.hpp"
+
+#include <filesystem>
+
+namespace Tools
+{
+	/*
+		Writes all blocks of "buffer" to a new file at "path".
+	*/
+	bool WriteFile(const std::filesystem::path& path, const HAP::ArenaBuffer& buffer);
+
+	/*
+		Each command gets the arguments following its name and
+		returns the process exit code.
+	*/
+	int Text(int argc, char** argv);
+	int Binary(int argc, char** argv);
+}
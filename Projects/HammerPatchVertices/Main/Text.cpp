@@ -0,0 +1,67 @@
+#include "Commands.hpp"
+
+#include "Application/Modules/Save Load/VertexFile.hpp"
+#include "Application/Modules/Save Load/VertexText.hpp"
+
+#include <cstdio>
+#include <chrono>
+
+namespace
+{
+	namespace fs = std::filesystem;
+}
+
+namespace Tools
+{
+	/*
+		The .hpvertstext form of a vertex file, for maps that were saved with "-hpnotext".
+	*/
+	int Text(int argc, char** argv)
+	{
+		if (argc < 1 || argc > 2)
+		{
+			std::printf("Expected a vertex file and optionally where to write the text\n");
+			return 2;
+		}
+
+		auto input = fs::u8path(argv[0]);
+		auto output = input;
+
+		if (argc == 2)
+		{
+			output = fs::u8path(argv[1]);
+		}
+
+		else
+		{
+			output.replace_extension(".hpvertstext");
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		HAP::VertexFile::MappedVertexFile file;
+		auto res = file.Open(input);
+
+		if (res != HAP::VertexFile::LoadStatus::Success)
+		{
+			std::printf("Could not load \"%s\": %s\n", argv[0], HAP::VertexFile::LoadStatusToString(res));
+			return 1;
+		}
+
+		HAP::ArenaBuffer text;
+		HAP::VertexFile::Text::Render(file, text);
+
+		if (!WriteFile(output, text))
+		{
+			std::printf("Could not write \"%s\"\n", output.string().c_str());
+			return 1;
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		auto seconds = std::chrono::duration<double>(end - start).count();
+
+		std::printf("Wrote %zu solids and %zu faces to \"%s\" in %.1f ms\n", file.GetSolids().size(), file.GetFaces().size(), output.string().c_str(), seconds * 1e3);
+
+		return 0;
+	}
+}
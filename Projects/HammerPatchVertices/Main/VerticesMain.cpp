@@ -0,0 +1,69 @@
+#include "Commands.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	struct CommandInfo
+	{
+		const char* Name;
+		const char* Arguments;
+		int(*Function)(int argc, char** argv);
+	};
+
+	const CommandInfo Commands[] =
+	{
+		{ "text", "<.hpverts> [output]", Tools::Text },
+		{ "binary", "[-compress] <.hpvertstext> [output]", Tools::Binary },
+	};
+
+	void PrintUsage(const char* program)
+	{
+		std::printf("Usage:\n");
+
+		for (const auto& command : Commands)
+		{
+			std::printf("  %s %s %s\n", program, command.Name, command.Arguments);
+		}
+	}
+}
+
+bool Tools::WriteFile(const std::filesystem::path& path, const HAP::ArenaBuffer& buffer)
+{
+	auto file = std::fopen(path.string().c_str(), "wb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	auto ret = buffer.ForEachBlock([&](const uint8_t* data, size_t size)
+	{
+		return std::fwrite(data, size, 1, file) == 1;
+	});
+
+	if (std::fclose(file) != 0)
+	{
+		ret = false;
+	}
+
+	return ret;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2)
+	{
+		for (const auto& command : Commands)
+		{
+			if (std::strcmp(argv[1], command.Name) == 0)
+			{
+				return command.Function(argc - 2, argv + 2);
+			}
+		}
+	}
+
+	PrintUsage(argv[0]);
+	return 2;
+}